@@ -1,7 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <iosfwd>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <matchable/matchable.h>
 
 
@@ -10,26 +18,115 @@ namespace matchable
 {
     MATCHABLE(save__status, success, no_content, no_grow_mode, io_error, cyclic_dependencies);
     MATCHABLE(save__content, generated_matchable, matchables);
-    MATCHABLE(save__grow_mode, wrap, always);
-    MATCHABLE(load__status, success, io_error, syntax_error);
+    // table prints the variants and properties of each matchable as constant arrays registered at startup
+    // (see matchable::register_variant_table()) instead of a class per variant
+    MATCHABLE(save__grow_mode, wrap, always, table);
+    MATCHABLE(
+        load__status,
+        success,
+        io_error,
+        syntax_error,
+        bad_snapshot,
+        unsupported_version,
+        no_import_format
+    );
+    MATCHABLE(import__format, csv, tsv, jsonl);
+    MATCHABLE(diff__kind, added, removed, changed);
     MATCHABLE(set_property_status, success, variant_lookup_failed, property_lookup_failed);
     namespace set_propertyvect_status = set_property_status;
 
+    // Variants and their property values allocate from the memory resource of the vector holding them (the
+    // pool of the maker they belong to), so that a maker's many small strings and vectors neither reach the
+    // global heap nor need freeing one by one
+    struct MatchableProperty
+    {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        MatchableProperty() = default;
+        explicit MatchableProperty(allocator_type a) : value{a}, values{a} {}
+        MatchableProperty(MatchableProperty const & o, allocator_type a)
+            : value{o.value, a}, values{o.values, a} {}
+        MatchableProperty(MatchableProperty && o, allocator_type a)
+            : value{std::move(o.value), a}, values{std::move(o.values), a} {}
+        MatchableProperty(MatchableProperty const &) = default;
+        MatchableProperty(MatchableProperty &&) = default;
+        MatchableProperty & operator=(MatchableProperty const &) = default;
+        MatchableProperty & operator=(MatchableProperty &&) = default;
+
+        std::pmr::string value;
+        std::pmr::vector<std::pmr::string> values;
+        bool is_set() const { return value.size() > 0 || values.size() > 0; }
+        bool operator==(MatchableProperty const &) const = default;
+    };
+
     struct MatchableVariant
     {
-        std::string variant_name;
-        //                     property name, property value, property vector value
-        std::vector<std::tuple<std::string, std::string, std::vector<std::string>>> properties;
-        bool operator==(std::string const & other) const { return variant_name == other; }
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        MatchableVariant() = default;
+        explicit MatchableVariant(allocator_type a) : variant_name{a}, properties{a} {}
+        explicit MatchableVariant(std::string_view name, allocator_type a = {})
+            : variant_name{name, a}, properties{a} {}
+        MatchableVariant(MatchableVariant const & o, allocator_type a)
+            : variant_name{o.variant_name, a}, properties{o.properties, a} {}
+        MatchableVariant(MatchableVariant && o, allocator_type a)
+            : variant_name{std::move(o.variant_name), a}, properties{std::move(o.properties), a} {}
+        MatchableVariant(MatchableVariant const &) = default;
+        MatchableVariant(MatchableVariant &&) = default;
+        MatchableVariant & operator=(MatchableVariant const &) = default;
+        MatchableVariant & operator=(MatchableVariant &&) = default;
+
+        std::pmr::string variant_name;
+        // indexed by property id (position within property_types_and_names), trailing unset ones omitted
+        std::pmr::vector<MatchableProperty> properties;
+        bool operator==(std::string_view other) const { return variant_name == other; }
+    };
+
+    // Strings copied once into a monotonic arena and shared from there, released all at once with the pool
+    class StringPool
+    {
+    public:
+        StringPool() = default;
+        StringPool(StringPool const &) = delete;
+        StringPool & operator=(StringPool const &) = delete;
+        std::string_view intern(std::string_view s);
+        // copy s into the arena without looking for an equal string (for strings known to be unique)
+        std::string_view copy(std::string_view s);
+        std::pmr::memory_resource * resource() { return &arena; }
+        // for containers erasing elements or rehashing, reusing freed memory rather than leaving it behind
+        std::pmr::memory_resource * node_resource() { return &nodes; }
+    private:
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::unsynchronized_pool_resource nodes;
+        std::pmr::unordered_set<std::string_view> interned{&arena};
+    };
+
+    // A difference between makers, concerning a whole matchable (variant and property empty), a property
+    // declaration (variant empty), a whole variant (property empty) or the value of a variant's property
+    struct MatchableChange
+    {
+        diff__kind::Type kind;
+        std::string matchable;
+        std::string variant;
+        std::string property;
     };
 
     class Matchable
     {
         friend class MatchableMaker;
+        // declared ahead of the public members, which allocate from pool
+        std::unique_ptr<StringPool> own_pool;
+        StringPool * pool;
     public:
+        // standalone matchables own their pool, those grabbed from a MatchableMaker share the maker's
+        Matchable();
+        explicit Matchable(StringPool * pool);
         void add_variant(std::string const & variant_name);
         void del_variant(std::string const & variant_name);
         void variants_starting_with(std::string const & prefix, std::vector<std::string> & result);
+        // sorted variant names starting with prefix, valid until variants are next added or removed
+        using variant_name_iterator = std::pmr::set<std::string_view, std::less<>>::const_iterator;
+        std::pair<variant_name_iterator, variant_name_iterator> variants_with_prefix(
+            std::string const & prefix
+        );
         bool has_variant(std::string const & variant_name);
         bool add_property(std::string const & property_type, std::string const & property_name);
         set_property_status::Type set_property(
@@ -53,32 +150,169 @@ namespace matchable
             std::vector<std::string> & property_values
         );
         std::string name;
-        std::vector<MatchableVariant> variants;
+        std::pmr::vector<MatchableVariant> variants;
         std::vector<std::pair<std::string, std::string>> property_types_and_names;
     private:
         set_property_status::Type verify_property_and_variant__and__get_variant_iter(
             std::string const & property,
             std::string const & variant,
-            std::vector<MatchableVariant>::iterator & iter
+            std::pmr::vector<MatchableVariant>::iterator & iter,
+            size_t & property_id
+        );
+
+        // position of property_name within property_types_and_names, or -1
+        int property_id(std::string_view property_name);
+
+        // position of variant_name within variants, or -1
+        int variant_position(std::string_view variant_name);
+        // as above, checking likely_position first (for walking matchables with variants in the same order)
+        int variant_position(std::string_view variant_name, size_t likely_position);
+        // position of variant_name within variants, adding it first if needed
+        size_t add_or_find_variant(std::string const & variant_name);
+        void sync_variant_indexes();
+        void rebuild_variant_indexes();
+
+        // replace property declarations and variants (and with them every property value)
+        void replace(
+            std::vector<std::pair<std::string, std::string>> && new_property_types_and_names,
+            std::pmr::vector<MatchableVariant> && new_variants
         );
+
+        // record a modification, revisions are unique across all matchables
+        void touch();
+        uint64_t revision{0};
+
+        // indexes of variant names (copied into pool, where copies of deleted names remain until the pool is
+        // released), rebuilt when the public variants vector changes size
+        // or when a name looked up is no longer at its indexed position. Replacing variants directly while
+        // keeping their number is only detected for names that were indexed, so a name added that way is
+        // not found until the size next changes (add_variant() and del_variant() keep the indexes exact).
+        std::pmr::unordered_map<std::string_view, size_t> variant_positions;
+        std::pmr::set<std::string_view, std::less<>> sorted_variant_names;
+
+        // index of property names (interned in pool), rebuilt if property_types_and_names is modified
+        // directly
+        std::pmr::unordered_map<std::string_view, size_t> property_ids;
     };
 
     class MatchableMaker
     {
     public:
         MatchableMaker();
+        MatchableMaker(MatchableMaker const &) = delete;
+        MatchableMaker & operator=(MatchableMaker const &) = delete;
         ~MatchableMaker();
+        // matchables are allocated from the maker's arena and remain valid for the lifetime of the maker,
+        // unless merge() removes them (load_snapshot() replaces contents in place)
         Matchable * grab(std::string const & m);
         save__status::Type save_as(
             std::string const & filename,
             save__content::Flags const & content,
             save__grow_mode::Type mode
         );
+        // Save a header declaring the matchables without their variants along with shard_count source files
+        // (named after the header: dict.h -> dict_0.cpp, dict_1.cpp, ...) that grow the matchables and set
+        // their properties. Only the shards need to be compiled along with the project, and they can be
+        // compiled in parallel.
+        save__status::Type save_sharded(
+            std::string const & header_filename,
+            int shard_count,
+            save__content::Flags const & content
+        );
+        static std::string shard_filename(std::string const & header_filename, int shard);
+        // Save each matchable to its own header within directory (named after the matchable, including the
+        // headers of the matchables it depends on) along with generated_matchable.h when requested. Headers
+        // are only rewritten when their contents change, preserving timestamps so that build tools skip
+        // anything depending only on unchanged matchables. Matchables that have not been modified since
+        // they were last saved here, and whose dependencies are the same, are not printed again (direct
+        // modification of the public members is only noticed if the number of variants changes). As with
+        // save_as(), matchables depending on cyclic dependencies are left out.
+        save__status::Type save_each(
+            std::string const & directory,
+            save__content::Flags const & content,
+            save__grow_mode::Type mode
+        );
         load__status::Type load(std::string const & filename);
+        // Stream variants of matchable m along with their property values from delimited text in a single
+        // pass, holding only one record in memory at a time. Variant names are plain strings, escaped here
+        // (spider-monkey -> spider_mns_monkey) and prefixed where they would not be usable identifiers
+        // (17 -> esc_17, class -> esc_class, Type -> esc_Type, _X -> esc__X), and names holding bytes
+        // without escape code (control characters or anything beyond ASCII) are a syntax error. Property
+        // values are used as given, empty ones are skipped and properties must already have been added
+        // with add_property(). Variants already present are updated. Records are imported as they are
+        // read, so on a syntax error every record before the failing one remains imported.
+        //   - csv, tsv: a header row names the columns, the first holds variant names and each other one a
+        //               property (csv fields may be quoted with "" escaping quotes and spanning lines)
+        //   - jsonl: one object per line, the first member holds the variant name and every other member a
+        //            property, arrays setting vector properties (null leaves a property unset)
+        load__status::Type import_variants(
+            std::string const & m,
+            std::string const & filename,
+            import__format::Type format
+        );
+        load__status::Type import_variants(
+            std::string const & m,
+            std::istream & in,
+            import__format::Type format
+        );
+        // Save or restore the maker's state in a compact binary format (string table, variant arrays and
+        // property columns) that loads directly from a memory mapped file. Loading replaces the contents of
+        // matchables of the same name, and only once the whole snapshot has been read, so that a snapshot
+        // failing to load leaves the maker unchanged. Properties of each variant are restored in
+        // declaration order.
+        save__status::Type save_snapshot(std::string const & filename);
+        load__status::Type load_snapshot(std::string const & filename);
+        // Changes turning this maker into other, found through the name indexes in linear time. Matchables
+        // are listed in name order, each with its property declarations followed by its variants. Added
+        // matchables and variants are listed without their contents.
+        std::vector<MatchableChange> diff(MatchableMaker & other);
+        // Three-way merge of the changes from base to other into this maker, each variant's property value
+        // being merged on its own. Where this maker changed something differently than other did, this
+        // maker's version is kept and other's change is returned as a conflict. Matchables that other
+        // removed and this maker left unchanged are destroyed.
+        std::vector<MatchableChange> merge(MatchableMaker & base, MatchableMaker & other);
         std::map<std::string, Matchable *> matchables;
     private:
-        std::string print_matchable_fwd(Matchable const & m);
-        std::string print_matchable(Matchable const & m, save__grow_mode::Type mode);
-        std::string print_set_property(Matchable const & m);
+        // the arena backing the matchables along with their variant and property names
+        StringPool pool;
+        Matchable * new_matchable(std::string const & name);
+        void destroy_matchable(Matchable * m);
+
+        // matchables ordered so that each follows the matchables its properties depend on, false if cyclic
+        bool order_by_dependencies(std::vector<Matchable const *> & ordered);
+        // before or after is nullptr for an added or removed matchable
+        static void diff_matchables(
+            Matchable * before,
+            Matchable * after,
+            std::string const & name,
+            std::vector<MatchableChange> & changes
+        );
+        static void merge_matchables(
+            Matchable & mine,
+            Matchable * base,
+            Matchable & theirs,
+            std::vector<MatchableChange> & conflicts
+        );
+        // write contents to filename unless it already holds them
+        bool update_file(std::string const & filename, std::string const & contents);
+        // the print_*() functions append to out and only read m, so they may run concurrently
+        // print_size() is an upper bound of what print_matchable() and print_set_property() append for m
+        static size_t print_size(Matchable const & m);
+        void print_generated_matchable(save__grow_mode::Type mode, std::string & out);
+        static void print_matchable_fwd(Matchable const & m, std::string & out);
+        static void print_matchable_declaration(Matchable const & m, std::string & out);
+        static void print_matchable(Matchable const & m, save__grow_mode::Type mode, std::string & out);
+        static void print_matchable_table(Matchable const & m, std::string & out);
+        static void print_set_property(Matchable const & m, std::string & out);
+
+        struct SavedOutput
+        {
+            uint64_t hash{0};
+            uint64_t revision{0};
+            save__grow_mode::Type mode;
+            // #include lines of the matchables depended on when saved (by save_each())
+            std::string dependency_includes;
+        };
+        std::map<std::string, SavedOutput> saved_outputs;
     };
 }
@@ -0,0 +1,185 @@
+#pragma once
+
+/*
+Copyright (c) 2019-2023, shtroizel
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <matchable/matchable.h>
+
+
+
+namespace matchable
+{
+    // Wait until every notify_observers() call that started before this call has returned, so that a
+    // dispatcher uninstalled beforehand can no longer be within dispatch(). Must not be called from within
+    // dispatch() or from an observer run inline by it.
+    inline void wait_for_observer_dispatches()
+    {
+        static std::mutex m;
+        std::lock_guard<std::mutex> lock{m};
+        ObserverDispatchEpochs & epochs = observer_dispatch_epochs();
+        std::atomic<size_t> const & in_flight = epochs.in_flight[epochs.epoch++ & 1];
+        while (in_flight > 0)
+            std::this_thread::yield();
+    }
+
+
+    // Run property observers on a pool of worker threads instead of inline within set_*()
+    //
+    // The pool installs itself as the observer dispatcher for its lifetime (the previous dispatcher is
+    // restored on destruction, which then waits for setters still dispatching to it). Observers of the
+    // same variant and property always run on the same worker, so their notifications are delivered in
+    // the order the property was set.
+    class AsyncObserverPool : public ObserverDispatcher
+    {
+    public:
+        explicit AsyncObserverPool(size_t worker_count = std::thread::hardware_concurrency());
+        AsyncObserverPool(AsyncObserverPool const &) = delete;
+        AsyncObserverPool & operator=(AsyncObserverPool const &) = delete;
+        ~AsyncObserverPool() override;
+        void dispatch(ObserverKey key, std::vector<std::function<void ()>> const & observers) override;
+
+        // block until every queued observer has run, not to be called from an observer (it would wait for
+        // itself)
+        void drain();
+
+    private:
+        struct Worker
+        {
+            std::mutex m;
+            std::condition_variable cv;
+            std::deque<std::vector<std::function<void ()>>> queue;
+            bool stopping{false};
+            std::thread thread;
+        };
+        void run(Worker & w);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        ObserverDispatcher * prev_dispatcher{nullptr};
+        std::mutex pending_m;
+        std::condition_variable pending_cv;
+        size_t pending{0};
+    };
+
+
+    inline AsyncObserverPool::AsyncObserverPool(size_t worker_count)
+    {
+        if (worker_count == 0)
+            worker_count = 1;
+
+        for (size_t i = 0; i < worker_count; ++i)
+            workers.push_back(std::make_unique<Worker>());
+        for (auto & w : workers)
+            w->thread = std::thread([this, &w = *w](){ run(w); });
+
+        prev_dispatcher = observer_dispatcher().exchange(this);
+    }
+
+
+    inline AsyncObserverPool::~AsyncObserverPool()
+    {
+        observer_dispatcher().store(prev_dispatcher);
+        wait_for_observer_dispatches();
+        drain();
+
+        for (auto & w : workers)
+        {
+            {
+                std::lock_guard<std::mutex> lock{w->m};
+                w->stopping = true;
+            }
+            w->cv.notify_one();
+        }
+        for (auto & w : workers)
+            w->thread.join();
+    }
+
+
+    inline void AsyncObserverPool::dispatch(
+        ObserverKey key,
+        std::vector<std::function<void ()>> const & observers
+    )
+    {
+        {
+            std::lock_guard<std::mutex> lock{pending_m};
+            ++pending;
+        }
+
+        size_t const h = std::hash<void const *>{}(key.property) * 31 + std::hash<int>{}(key.variant);
+        Worker & w = *workers[h % workers.size()];
+        {
+            std::lock_guard<std::mutex> lock{w.m};
+            w.queue.push_back(observers);
+        }
+        w.cv.notify_one();
+    }
+
+
+    inline void AsyncObserverPool::drain()
+    {
+        std::unique_lock<std::mutex> lock{pending_m};
+        pending_cv.wait(lock, [&](){ return pending == 0; });
+    }
+
+
+    inline void AsyncObserverPool::run(Worker & w)
+    {
+        while (true)
+        {
+            std::vector<std::function<void ()>> observers;
+            {
+                std::unique_lock<std::mutex> lock{w.m};
+                w.cv.wait(lock, [&](){ return w.stopping || !w.queue.empty(); });
+                if (w.queue.empty())
+                    return;
+                observers = std::move(w.queue.front());
+                w.queue.pop_front();
+            }
+
+            for (auto const & f : observers)
+                f();
+
+            {
+                std::lock_guard<std::mutex> lock{pending_m};
+                --pending;
+            }
+            pending_cv.notify_all();
+        }
+    }
+}
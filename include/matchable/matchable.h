@@ -34,11 +34,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <ostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 
@@ -64,6 +73,9 @@ namespace matchable
         std::vector<M> currently_set() const;
 
     private:
+        // variants may be registered after construction (GROW_MATCHABLE within other translation units)
+        size_t grow_for(size_t index);
+
         T nil_target;
         bool nil_target_init_flag;
         T default_t;
@@ -84,10 +96,10 @@ namespace matchable
         , nil_target_init_flag{false}
         , default_t{fill}
     {
-        targets.reserve(M::variants().size());
-        init_flags.reserve(M::variants().size());
+        targets.reserve(M::all_variants_by_string().size());
+        init_flags.reserve(M::all_variants_by_string().size());
 
-        for (size_t i = 0; i < M::variants().size(); ++i)
+        for (size_t i = 0; i < M::all_variants_by_string().size(); ++i)
         {
             targets.push_back(default_t);
             init_flags.push_back(false);
@@ -107,14 +119,21 @@ namespace matchable
     template<typename M, typename T>
     T const & MatchBox<M, T>::at(M const & match) const
     {
-        return match.is_nil() ? nil_target : targets[static_cast<size_t>((match.*as_index_func)())];
+        if (match.is_nil())
+            return nil_target;
+
+        size_t const index = static_cast<size_t>((match.*as_index_func)());
+        return index < targets.size() ? targets[index] : default_t;
     }
 
 
     template<typename M, typename T>
     T & MatchBox<M, T>::mut_at(M const & match)
     {
-        return match.is_nil() ? nil_target : targets[static_cast<size_t>((match.*as_index_func)())];
+        if (match.is_nil())
+            return nil_target;
+
+        return targets[grow_for(static_cast<size_t>((match.*as_index_func)()))];
     }
 
 
@@ -128,7 +147,7 @@ namespace matchable
         }
         else
         {
-            size_t index = static_cast<size_t>((match.*as_index_func)());
+            size_t index = grow_for(static_cast<size_t>((match.*as_index_func)()));
             targets[index] = target;
             init_flags[index] = true;
         }
@@ -146,8 +165,11 @@ namespace matchable
         else
         {
             size_t index = static_cast<size_t>((match.*as_index_func)());
-            targets[index] = default_t;
-            init_flags[index] = false;
+            if (index < targets.size())
+            {
+                targets[index] = default_t;
+                init_flags[index] = false;
+            }
         }
     }
 
@@ -158,7 +180,20 @@ namespace matchable
         if (match.is_nil())
             return nil_target_init_flag;
 
-        return init_flags[static_cast<size_t>((match.*as_index_func)())];
+        size_t const index = static_cast<size_t>((match.*as_index_func)());
+        return index < init_flags.size() && init_flags[index];
+    }
+
+
+    template<typename M, typename T>
+    size_t MatchBox<M, T>::grow_for(size_t index)
+    {
+        if (index >= targets.size())
+        {
+            targets.resize(index + 1, default_t);
+            init_flags.resize(index + 1, false);
+        }
+        return index;
     }
 
 
@@ -200,6 +235,8 @@ namespace matchable
         }
 
     private:
+        size_t grow_for(size_t index);
+
         bool nil_init_flag;
         std::vector<bool> init_flags;
         using as_index_func_type = int (M::*)() const;
@@ -214,8 +251,8 @@ namespace matchable
     template<typename M>
     MatchBox<M, void>::MatchBox() : nil_init_flag{false}
     {
-        init_flags.reserve(M::variants().size());
-        for (size_t i = 0; i < M::variants().size(); ++i)
+        init_flags.reserve(M::all_variants_by_string().size());
+        for (size_t i = 0; i < M::all_variants_by_string().size(); ++i)
             init_flags.push_back(false);
     }
 
@@ -243,7 +280,7 @@ namespace matchable
         if (match.is_nil())
             nil_init_flag = true;
         else
-            init_flags[static_cast<size_t>((match.*as_index_func)())] = true;
+            init_flags[grow_for(static_cast<size_t>((match.*as_index_func)()))] = true;
     }
 
 
@@ -253,7 +290,7 @@ namespace matchable
         if (match.is_nil())
             nil_init_flag = false;
         else
-            init_flags[static_cast<size_t>((match.*as_index_func)())] = false;
+            init_flags[grow_for(static_cast<size_t>((match.*as_index_func)()))] = false;
     }
 
 
@@ -261,10 +298,14 @@ namespace matchable
     void MatchBox<M, void>::toggle(M const & match)
     {
         if (match.is_nil())
+        {
             nil_init_flag = !nil_init_flag;
+        }
         else
-            init_flags[static_cast<size_t>((match.*as_index_func)())] =
-                    !init_flags[static_cast<size_t>((match.*as_index_func)())];
+        {
+            size_t const index = grow_for(static_cast<size_t>((match.*as_index_func)()));
+            init_flags[index] = !init_flags[index];
+        }
     }
 
 
@@ -274,7 +315,8 @@ namespace matchable
         if (match.is_nil())
             return nil_init_flag;
 
-        return init_flags[static_cast<size_t>((match.*as_index_func)())];
+        size_t const index = static_cast<size_t>((match.*as_index_func)());
+        return index < init_flags.size() && init_flags[index];
     }
 
 
@@ -292,7 +334,21 @@ namespace matchable
     template<typename M>
     bool MatchBox<M, void>::operator==(MatchBox<M, void> const & other) const
     {
-        return init_flags == other.init_flags;
+        // either may not have grown yet for the most recently registered variants
+        auto flag = [](std::vector<bool> const & flags, size_t i) { return i < flags.size() && flags[i]; };
+        for (size_t i = 0; i < std::max(init_flags.size(), other.init_flags.size()); ++i)
+            if (flag(init_flags, i) != flag(other.init_flags, i))
+                return false;
+        return true;
+    }
+
+
+    template<typename M>
+    size_t MatchBox<M, void>::grow_for(size_t index)
+    {
+        if (index >= init_flags.size())
+            init_flags.resize(index + 1, false);
+        return index;
     }
 
 
@@ -303,6 +359,181 @@ namespace matchable
     }
 
 
+    // Associative array of variable length arrays for matchables
+    //
+    // Rather than a separate std::vector per variant, all elements are kept within a single contiguous
+    // arena with each variant referencing a slice (offset, size) of it. Variants keep their slice when set
+    // to a value that fits, otherwise the new value is appended and the arena is compacted once more than
+    // half of it is no longer referenced. Spans returned by at() and mut_at() are valid until the next
+    // set().
+    template<typename M, typename T>
+    class SpanMatchBox
+    {
+    public:
+        using match_t = M;
+        using target_t = T;
+
+        std::span<T const> at(M const &) const;
+        std::span<T> mut_at(M const &);
+        void set(M const &, std::span<T const>);
+        void unset(M const &);
+        bool is_set(M const &) const;
+
+    private:
+        struct Slot
+        {
+            size_t offset{0};
+            size_t size{0};
+            size_t capacity{0};
+            bool init_flag{false};
+        };
+        Slot & slot(M const &);
+        void compact();
+
+        Slot nil_slot;
+        std::vector<Slot> slots;
+        std::vector<T> elements;
+        size_t unreferenced{0};
+        using as_index_func_type = int (M::*)() const;
+#ifdef MATCHABLE_OMIT_BY_INDEX
+        as_index_func_type as_index_func = &M::as_by_string_index;
+#else
+        as_index_func_type as_index_func = &M::as_index;
+#endif
+    };
+
+
+    template<typename M, typename T>
+    std::span<T const> SpanMatchBox<M, T>::at(M const & match) const
+    {
+        Slot const * s = &nil_slot;
+        if (!match.is_nil())
+        {
+            size_t index = static_cast<size_t>((match.*as_index_func)());
+            if (index >= slots.size())
+                return {};
+            s = &slots[index];
+        }
+        return std::span<T const>(elements.data() + s->offset, s->size);
+    }
+
+
+    template<typename M, typename T>
+    std::span<T> SpanMatchBox<M, T>::mut_at(M const & match)
+    {
+        Slot & s = slot(match);
+        return std::span<T>(elements.data() + s.offset, s.size);
+    }
+
+
+    template<typename M, typename T>
+    void SpanMatchBox<M, T>::set(M const & match, std::span<T const> values)
+    {
+        // values may be a slice of this very arena which would be invalidated by growing it
+        if (
+            values.size() > 0 && elements.size() > 0 &&
+            values.data() >= elements.data() && values.data() < elements.data() + elements.size()
+        )
+        {
+            std::vector<T> const copy(values.begin(), values.end());
+            set(match, std::span<T const>(copy));
+            return;
+        }
+
+        Slot & s = slot(match);
+        s.init_flag = true;
+        if (values.size() <= s.capacity)
+        {
+            std::copy(values.begin(), values.end(), elements.begin() + s.offset);
+            s.size = values.size();
+            return;
+        }
+
+        unreferenced += s.capacity;
+        s.offset = elements.size();
+        s.size = values.size();
+        s.capacity = values.size();
+        elements.insert(elements.end(), values.begin(), values.end());
+
+        if (unreferenced > elements.size() / 2)
+            compact();
+    }
+
+
+    template<typename M, typename T>
+    void SpanMatchBox<M, T>::unset(M const & match)
+    {
+        Slot & s = slot(match);
+        s.size = 0;
+        s.init_flag = false;
+    }
+
+
+    template<typename M, typename T>
+    bool SpanMatchBox<M, T>::is_set(M const & match) const
+    {
+        if (match.is_nil())
+            return nil_slot.init_flag;
+
+        size_t index = static_cast<size_t>((match.*as_index_func)());
+        return index < slots.size() && slots[index].init_flag;
+    }
+
+
+    template<typename M, typename T>
+    typename SpanMatchBox<M, T>::Slot & SpanMatchBox<M, T>::slot(M const & match)
+    {
+        if (match.is_nil())
+            return nil_slot;
+
+        size_t index = static_cast<size_t>((match.*as_index_func)());
+        if (index >= slots.size())
+            slots.resize(index + 1);
+        return slots[index];
+    }
+
+
+    template<typename M, typename T>
+    void SpanMatchBox<M, T>::compact()
+    {
+        std::vector<T> compacted;
+        compacted.reserve(elements.size() - unreferenced);
+
+        auto compact_slot =
+            [&](Slot & s)
+            {
+                size_t offset = compacted.size();
+                compacted.insert(
+                    compacted.end(),
+                    elements.begin() + s.offset,
+                    elements.begin() + s.offset + s.size
+                );
+                s.offset = offset;
+                s.capacity = s.size;
+            };
+        compact_slot(nil_slot);
+        for (auto & s : slots)
+            compact_slot(s);
+
+        elements = std::move(compacted);
+        unreferenced = 0;
+    }
+
+
+    // Freezing makes property values read-only so that they may be read concurrently without locking.
+    // Matchables are frozen either individually with <type>::freeze() or all at once with freeze_all().
+    inline std::atomic<bool> & all_frozen() { static std::atomic<bool> f{false}; return f; }
+    inline void freeze_all() { all_frozen() = true; }
+
+
+    // Called when a property of a frozen matchable is about to be modified (fails fast)
+    [[noreturn]] inline void frozen_property_modified(char const * property)
+    {
+        std::fprintf(stderr, "matchable: attempt to modify frozen property %s\n", property);
+        std::abort();
+    }
+
+
     class FlowControl
     {
     public:
@@ -316,51 +547,331 @@ namespace matchable
     };
 
 
+    // Identifies the variant and property that was set: property is the address of the property's
+    // observer storage (a function local static) and variant the variant's index, or -1 for nil
+    struct ObserverKey
+    {
+        void const * property;
+        int variant;
+        bool operator==(ObserverKey const &) const = default;
+    };
+
+
+    // Property observers are run by the installed ObserverDispatcher. Without an installed dispatcher
+    // (the default) observers run inline within set_*(). See matchable/async_observers.h
+    class ObserverDispatcher
+    {
+    public:
+        virtual ~ObserverDispatcher() = default;
+        // observers sharing a key run in order
+        virtual void dispatch(ObserverKey key, std::vector<std::function<void ()>> const & observers) = 0;
+    };
+
+
+    inline std::atomic<ObserverDispatcher *> & observer_dispatcher()
+    {
+        static std::atomic<ObserverDispatcher *> d{nullptr};
+        return d;
+    }
+
+
+    // Calls to notify_observers() that may be within a dispatcher's dispatch(), counted before the dispatcher
+    // is loaded so that a dispatcher being uninstalled can wait for every call that loaded it (see
+    // wait_for_observer_dispatches() in matchable/async_observers.h). Each call counts toward the epoch it
+    // started in, so waiting on an epoch is not held up by later calls.
+    struct ObserverDispatchEpochs
+    {
+        std::atomic<size_t> epoch{0};
+        std::atomic<size_t> in_flight[2]{};
+    };
+
+
+    inline ObserverDispatchEpochs & observer_dispatch_epochs()
+    {
+        static ObserverDispatchEpochs e;
+        return e;
+    }
+
+
+    inline void notify_observers(ObserverKey key, std::vector<std::function<void ()>> const & observers)
+    {
+        if (observers.empty())
+            return;
+
+        ObserverDispatchEpochs & epochs = observer_dispatch_epochs();
+        std::atomic<size_t> & in_flight = epochs.in_flight[epochs.epoch & 1];
+        ++in_flight;
+        ObserverDispatcher * d = observer_dispatcher().load();
+        if (nullptr == d)
+        {
+            --in_flight;
+            for (auto const & f : observers)
+                f();
+        }
+        else
+        {
+            // still counted should dispatch() throw
+            struct Dispatched
+            {
+                std::atomic<size_t> & in_flight;
+                ~Dispatched() { --in_flight; }
+            } dispatched{in_flight};
+            d->dispatch(key, observers);
+        }
+    }
+
+
+    // Variants hidden by Unmatchable scopes
+    //
+    // The by string and by index vectors of a matchable are never modified while variants are hidden.
+    // Instead hidden variants are flagged here by their by string index and the visible variants are only
+    // materialized when asked for, so hiding or revealing k variants costs O(k).
+    //
+    // Each thread has its own visibility, so a scope only hides variants from the thread that entered it.
+    // While no scope is active on any thread, instance() returns a shared empty visibility without touching
+    // thread local storage.
+    template<typename M>
+    class VariantVisibility
+    {
+    public:
+        static VariantVisibility & instance() { return active_scopes() == 0 ? none() : local(); }
+        static VariantVisibility & local() { thread_local VariantVisibility v; return v; }
+        static std::atomic<size_t> & active_scopes() { static std::atomic<size_t> c{0}; return c; }
+
+        bool any_hidden() const { return hidden_count > 0; }
+        bool is_hidden(M const & m) const;
+        bool hide(M const & m);
+        void reveal(M const & m);
+        std::vector<M> const & visible_by_string(std::vector<M> const & all_by_string);
+        std::vector<M> const & visible_by_index(std::vector<M> const & all_by_index);
+
+    private:
+        static VariantVisibility & none() { static VariantVisibility v; return v; }
+        std::vector<M> const & visible(
+            std::vector<M> const & all,
+            std::vector<M> & cache,
+            bool & cache_valid
+        );
+
+        std::vector<bool> hidden;
+        size_t hidden_count{0};
+        std::vector<M> by_string_cache;
+        bool by_string_cache_valid{false};
+        std::vector<M> by_index_cache;
+        bool by_index_cache_valid{false};
+    };
+
+
+    template<typename M>
+    bool VariantVisibility<M>::is_hidden(M const & m) const
+    {
+        size_t const index = static_cast<size_t>(m.as_by_string_index());
+        return hidden_count > 0 && !m.is_nil() && index < hidden.size() && hidden[index];
+    }
+
+
+    template<typename M>
+    bool VariantVisibility<M>::hide(M const & m)
+    {
+        if (m.is_nil() || is_hidden(m))
+            return false;
+
+        size_t const index = static_cast<size_t>(m.as_by_string_index());
+        if (index >= hidden.size())
+            hidden.resize(M::all_variants_by_string().size(), false);
+        hidden[index] = true;
+        ++hidden_count;
+        by_string_cache_valid = false;
+        by_index_cache_valid = false;
+        return true;
+    }
+
+
+    template<typename M>
+    void VariantVisibility<M>::reveal(M const & m)
+    {
+        if (!is_hidden(m))
+            return;
+
+        hidden[static_cast<size_t>(m.as_by_string_index())] = false;
+        --hidden_count;
+        by_string_cache_valid = false;
+        by_index_cache_valid = false;
+    }
+
+
+    template<typename M>
+    std::vector<M> const & VariantVisibility<M>::visible_by_string(std::vector<M> const & all_by_string)
+    {
+        return visible(all_by_string, by_string_cache, by_string_cache_valid);
+    }
+
+
+    template<typename M>
+    std::vector<M> const & VariantVisibility<M>::visible_by_index(std::vector<M> const & all_by_index)
+    {
+        return visible(all_by_index, by_index_cache, by_index_cache_valid);
+    }
+
+
+    template<typename M>
+    std::vector<M> const & VariantVisibility<M>::visible(
+        std::vector<M> const & all,
+        std::vector<M> & cache,
+        bool & cache_valid
+    )
+    {
+        if (hidden_count == 0)
+            return all;
+
+        if (!cache_valid)
+        {
+            cache.clear();
+            cache.reserve(all.size() - std::min(all.size(), hidden_count));
+            for (auto const & m : all)
+                if (!is_hidden(m))
+                    cache.push_back(m);
+            cache_valid = true;
+        }
+        return cache;
+    }
+
+
+    // Hides variants from the current thread for the lifetime of the Unmatchable, which must be destroyed
+    // on the thread that created it
     template<typename M>
     class Unmatchable
     {
     public:
         Unmatchable(std::initializer_list<M> um)
         {
-            {
-                prev_variants_by_string = M::interface_type::variants_by_string();
-                auto i = std::remove_if(
-                             M::interface_type::by_string().begin(),
-                             M::interface_type::by_string().end(),
-                             [&](M m){ return std::find(um.begin(), um.end(), m) != um.end(); }
-                         );
-                M::interface_type::by_string().erase(i, M::interface_type::by_string().end());
-            }
-
-#ifndef MATCHABLE_OMIT_BY_INDEX
-            {
-                prev_variants_by_index = M::interface_type::variants_by_index();
-                M::interface_type::all_by_index() = &prev_variants_by_index;
-                auto i = std::remove_if(
-                             M::interface_type::by_index().begin(),
-                             M::interface_type::by_index().end(),
-                             [&](M m){ return std::find(um.begin(), um.end(), m) != um.end(); }
-                         );
-                M::interface_type::by_index().erase(i, M::interface_type::by_index().end());
-            }
-#endif
+            ++M::interface_type::generation_counter();
+            ++VariantVisibility<M>::active_scopes();
+            for (auto const & m : um)
+                if (VariantVisibility<M>::local().hide(m))
+                    hidden.push_back(m);
         }
         ~Unmatchable()
         {
-            M::interface_type::by_string() = prev_variants_by_string;
-#ifndef MATCHABLE_OMIT_BY_INDEX
-            M::interface_type::by_index() = prev_variants_by_index;
-            M::interface_type::all_by_index() = &M::interface_type::by_index();
-#endif
+            ++M::interface_type::generation_counter();
+            for (auto const & m : hidden)
+                VariantVisibility<M>::local().reveal(m);
+            --VariantVisibility<M>::active_scopes();
         }
+        Unmatchable(Unmatchable const &) = delete;
+        Unmatchable & operator=(Unmatchable const &) = delete;
     private:
-        std::vector<M> prev_variants_by_string;
-#ifndef MATCHABLE_OMIT_BY_INDEX
-        std::vector<M> prev_variants_by_index;
-#endif
+        // only the variants hidden by this scope (and not already hidden by an enclosing one)
+        std::vector<M> hidden;
+    };
+
+
+    // Filtered and ordered view of the variants of a matchable
+    //
+    // Predicates given to where() must all hold for a variant to be included. Keys given to order_by() sort
+    // the result with later keys breaking ties of earlier ones, and variants with equal keys keep their
+    // variants() order. Each key is extracted once per variant rather than once per comparison. The result
+    // is cached until a property of the matchable is modified or its variants change, and is only reused
+    // under the same variant visibility (Unmatchable scopes of the calling thread). A Query is not
+    // synchronized, so each thread needs its own.
+    template<typename M>
+    class Query
+    {
+    public:
+        Query & where(std::function<bool (M const &)> pred);
+        template<typename K>
+        Query & order_by(K key);
+        std::vector<M> const & results() const;
+
+    private:
+        using ordering_type = std::function<void (std::vector<M> const &, std::vector<size_t> &)>;
+        std::vector<std::function<bool (M const &)>> predicates;
+        std::vector<ordering_type> orderings;
+        mutable std::vector<M> cached;
+        mutable size_t cached_generation{0};
+        mutable VariantVisibility<M> const * cached_visibility{nullptr};
+        mutable bool cache_valid{false};
     };
 
 
+    template<typename M>
+    Query<M> & Query<M>::where(std::function<bool (M const &)> pred)
+    {
+        predicates.push_back(pred);
+        cache_valid = false;
+        return *this;
+    }
+
+
+    template<typename M>
+    template<typename K>
+    Query<M> & Query<M>::order_by(K key)
+    {
+        orderings.push_back(
+            [key](std::vector<M> const & rows, std::vector<size_t> & perm)
+            {
+                using key_type = std::remove_cvref_t<decltype(key(std::declval<M const &>()))>;
+                std::vector<key_type> keys;
+                keys.reserve(rows.size());
+                for (auto const & r : rows)
+                    keys.push_back(key(r));
+                std::stable_sort(
+                    perm.begin(),
+                    perm.end(),
+                    [&keys](size_t a, size_t b) { return keys[a] < keys[b]; }
+                );
+            }
+        );
+        cache_valid = false;
+        return *this;
+    }
+
+
+    template<typename M>
+    std::vector<M> const & Query<M>::results() const
+    {
+        // each thread with active scopes has its own visibility, entering or leaving a scope bumps generation
+        size_t const generation = M::interface_type::generation();
+        VariantVisibility<M> const * visibility = &VariantVisibility<M>::instance();
+        if (cache_valid && cached_generation == generation && cached_visibility == visibility)
+            return cached;
+
+        std::vector<M> rows;
+        for (auto const & v : M::variants())
+            if (std::all_of(predicates.begin(), predicates.end(), [&v](auto const & p) { return p(v); }))
+                rows.push_back(v);
+
+        // stable sorting by the least significant key first leaves the result ordered by all keys
+        std::vector<size_t> perm(rows.size());
+        for (size_t i = 0; i < perm.size(); ++i)
+            perm[i] = i;
+        for (auto o = orderings.rbegin(); o != orderings.rend(); ++o)
+            (*o)(rows, perm);
+
+        cached.clear();
+        cached.reserve(rows.size());
+        for (auto i : perm)
+            cached.push_back(rows[i]);
+        cached_generation = generation;
+        cached_visibility = visibility;
+        cache_valid = true;
+        return cached;
+    }
+
+
+    // Position of a variant within a compile-time property table (see MATCHABLE_PROPERTY_CONSTANTS), also
+    // identifying the variant to observer dispatchers
+    template<typename M>
+    int property_table_index(M const & m)
+    {
+#ifdef MATCHABLE_OMIT_BY_INDEX
+        return m.as_by_string_index();
+#else
+        return m.as_index();
+#endif
+    }
+
+
     inline bool str_lt_str(std::string const & l, std::string const & r)
     {
         size_t const min_len = std::min(l.length(), r.length());
@@ -400,9 +911,21 @@ namespace matchable
             virtual int as_by_string_index() const = 0;                                                    \
             virtual std::string const & as_string() const = 0;                                             \
             virtual std::string const & as_identifier_string() const = 0;                                  \
-            static std::vector<Type> const & variants_by_string() { return by_string(); }                  \
+            static std::vector<Type> const & variants_by_string()                                          \
+                { return ::matchable::VariantVisibility<Type>::instance().visible_by_string(by_string()); }\
+            static std::vector<Type> const & all_variants_by_string() { return by_string(); }              \
             static bool register_variant(Type const & variant, int * i);                                   \
+            /* register many variants at once, by_string_order lists their positions sorted by string */   \
+            static void register_variants(std::vector<Type> && variants,                                   \
+                                          std::vector<int> const & by_string_order);                       \
+            static void freeze() { frozen_flag() = true; }                                                 \
+            static bool is_frozen() { return frozen_flag() || ::matchable::all_frozen(); }                 \
+            static size_t generation() { return generation_counter(); }                                    \
         private:                                                                                           \
+            static std::atomic<bool> & frozen_flag() { static std::atomic<bool> f{false}; return f; }      \
+            /* bumped whenever a property is modified or the variants change (see matchable::Query) */     \
+            static std::atomic<size_t> & generation_counter()                                              \
+                    { static std::atomic<size_t> g{0}; return g; }                                         \
             virtual void set_by_string_index(int index) = 0;                                               \
             virtual std::shared_ptr<I##t> clone() const = 0;                                               \
             static std::vector<Type> & by_string() { static std::vector<Type> v; return v; }
@@ -419,12 +942,11 @@ namespace matchable
         public:                                                                                            \
             virtual int as_index() const = 0;                                                              \
             static std::vector<Type> const & variants() { return variants_by_index(); }                    \
-            static std::vector<Type> const & variants_by_index() { return by_index(); }                    \
-            static std::vector<Type> const * all_variants_by_index() { return all_by_index(); }            \
+            static std::vector<Type> const & variants_by_index()                                           \
+                { return ::matchable::VariantVisibility<Type>::instance().visible_by_index(by_index()); }  \
+            static std::vector<Type> const * all_variants_by_index() { return &by_index(); }               \
         private:                                                                                           \
             static std::vector<Type> & by_index() { static std::vector<Type> v; return v; }                \
-            static std::vector<Type> *& all_by_index()                                                     \
-                    { static std::vector<Type> * v = &by_index(); return v; }                              \
         };                                                                                                 \
     }
 #endif
@@ -481,6 +1003,8 @@ namespace matchable
             static std::vector<MatchableType> const & variants() { return T::variants(); }                 \
             static std::vector<MatchableType> const & variants_by_string()                                 \
                 { return T::variants_by_string(); }                                                        \
+            static std::vector<MatchableType> const & all_variants_by_string()                             \
+                { return T::all_variants_by_string(); }                                                    \
             bool operator==(MatchableType const & m) const { return as_string() == m.as_string(); }        \
             bool operator!=(MatchableType const & m) const { return as_string() != m.as_string(); }        \
             bool lt_by_string(MatchableType const & m) const                                               \
@@ -520,6 +1044,8 @@ namespace matchable
         using Flags = matchable::MatchBox<Type, void>;                                                     \
         inline std::vector<Type> const & variants() { return I##t::variants(); }                           \
         inline std::vector<Type> const & variants_by_string() { return I##t::variants_by_string(); }       \
+        inline void freeze() { I##t::freeze(); }                                                           \
+        inline bool is_frozen() { return I##t::is_frozen(); }                                              \
         _Pragma("GCC diagnostic push")                                                                     \
         _Pragma("GCC diagnostic ignored \"-Wunused-const-variable\"")                                      \
         static std::string const name{#t};                                                                 \
@@ -527,39 +1053,35 @@ namespace matchable
         static Type nil{};                                                                                 \
         inline Type from_by_string_index(int index)                                                        \
         {                                                                                                  \
-            if (index < 0 || index >= (int) I##t::variants_by_string().size())                             \
+            if (index < 0 || index >= (int) I##t::all_variants_by_string().size())                         \
                 return nil;                                                                                \
-            return I##t::variants_by_string().at(index);                                                   \
+            Type const & v = I##t::all_variants_by_string()[index];                                        \
+            return ::matchable::VariantVisibility<Type>::instance().is_hidden(v) ? nil : v;                \
         }                                                                                                  \
         inline int variants_by_string_index_of(std::string const & str, bool * found)                      \
         {                                                                                                  \
             auto it = std::lower_bound(                                                                    \
-                I##t::variants_by_string().begin(),                                                        \
-                I##t::variants_by_string().end(),                                                          \
+                I##t::all_variants_by_string().begin(),                                                    \
+                I##t::all_variants_by_string().end(),                                                      \
                 str,                                                                                       \
                 [](t::Type const & v, std::string const & s){ return v.lt_by_string(s); }                  \
             );                                                                                             \
-            if (it == I##t::variants_by_string().end())                                                    \
+            if (it == I##t::all_variants_by_string().end())                                                \
             {                                                                                              \
                 if (nullptr != found)                                                                      \
                     *found = false;                                                                        \
-                return I##t::variants_by_string().size();                                                  \
+                return I##t::all_variants_by_string().size();                                              \
             }                                                                                              \
             if (nullptr != found)                                                                          \
-                *found = str == it->as_string();                                                           \
+                *found = str == it->as_string() &&                                                         \
+                         !::matchable::VariantVisibility<Type>::instance().is_hidden(*it);                 \
             return it->as_by_string_index();                                                               \
         }                                                                                                  \
         inline Type from_string(std::string const & str)                                                   \
         {                                                                                                  \
-            auto it = std::lower_bound(                                                                    \
-                I##t::variants_by_string().begin(),                                                        \
-                I##t::variants_by_string().end(),                                                          \
-                str,                                                                                       \
-                [](t::Type const & v, std::string const & s){ return v.lt_by_string(s); }                  \
-            );                                                                                             \
-            if (it != I##t::variants_by_string().end() && str == it->as_string())                          \
-                return *it;                                                                                \
-            return nil;                                                                                    \
+            bool found{false};                                                                             \
+            int const index = variants_by_string_index_of(str, &found);                                    \
+            return found ? I##t::all_variants_by_string()[index] : nil;                                    \
         }                                                                                                  \
         inline Type from_identifier_string(std::string const & str)                                        \
         {                                                                                                  \
@@ -573,22 +1095,41 @@ namespace matchable
 
 
 #define matchable_define_register_variant_common                                                           \
-            if (variant.is_nil())                                                                          \
-            {                                                                                              \
-                by_string().clear();                                                                       \
-            }                                                                                              \
-            else                                                                                           \
-            {                                                                                              \
-                if (nullptr != index)                                                                      \
-                    *index = static_cast<int>(variants().size());                                          \
-                static auto pred = [](auto const & a, auto const & b) { return a.lt_by_string(b); };       \
-                by_string().insert(                                                                        \
-                    std::upper_bound(by_string().begin(), by_string().end(), variant, pred),               \
-                    variant                                                                                \
-                );                                                                                         \
-                for (int i = 0; i < (int) by_string().size(); ++i)                                         \
-                    by_string()[i].set_by_string_index(i);                                                 \
-            }
+            ++generation_counter();                                                                        \
+            /* each translation unit registers the variants it sees, only the first registration counts */ \
+            if (variant.is_nil() || variant.as_by_string_index() != -1)                                    \
+                return true;                                                                               \
+            if (nullptr != index)                                                                          \
+                *index = static_cast<int>(all_variants_by_string().size());                                \
+            static auto pred = [](auto const & a, auto const & b) { return a.lt_by_string(b); };           \
+            by_string().insert(                                                                            \
+                std::upper_bound(by_string().begin(), by_string().end(), variant, pred),                   \
+                variant                                                                                    \
+            );                                                                                             \
+            for (int i = 0; i < (int) by_string().size(); ++i)                                             \
+                by_string()[i].set_by_string_index(i);
+
+
+#define matchable_define_register_variants_common                                                          \
+            ++generation_counter();                                                                        \
+            static auto pred = [](auto const & a, auto const & b) { return a.lt_by_string(b); };           \
+            std::vector<Type> sorted;                                                                      \
+            sorted.reserve(by_string_order.size());                                                        \
+            for (int position : by_string_order)                                                           \
+                sorted.push_back(variants[position]);                                                      \
+            std::vector<Type> merged;                                                                      \
+            merged.reserve(by_string().size() + sorted.size());                                            \
+            std::merge(                                                                                    \
+                std::make_move_iterator(by_string().begin()),                                              \
+                std::make_move_iterator(by_string().end()),                                                \
+                std::make_move_iterator(sorted.begin()),                                                   \
+                std::make_move_iterator(sorted.end()),                                                     \
+                std::back_inserter(merged),                                                                \
+                pred                                                                                       \
+            );                                                                                             \
+            by_string() = std::move(merged);                                                               \
+            for (int i = 0; i < (int) by_string().size(); ++i)                                             \
+                by_string()[i].set_by_string_index(i);
 
 
 #ifdef MATCHABLE_OMIT_BY_INDEX
@@ -601,6 +1142,13 @@ namespace matchable
             matchable_define_register_variant_common                                                       \
             return true;                                                                                   \
         }                                                                                                  \
+        inline void I##t::register_variants(                                                               \
+            std::vector<Type> && variants,                                                                 \
+            std::vector<int> const & by_string_order                                                       \
+        )                                                                                                  \
+        {                                                                                                  \
+            matchable_define_register_variants_common                                                      \
+        }                                                                                                  \
     }
 #else
 #define matchable_define(t)                                                                                \
@@ -610,17 +1158,28 @@ namespace matchable
         inline bool I##t::register_variant(Type const & variant, int * index)                              \
         {                                                                                                  \
             matchable_define_register_variant_common                                                       \
-            variant.is_nil() ? by_index().clear() : by_index().push_back(variant);                         \
+            by_index().push_back(variant);                                                                 \
             return true;                                                                                   \
         }                                                                                                  \
+        inline void I##t::register_variants(                                                               \
+            std::vector<Type> && variants,                                                                 \
+            std::vector<int> const & by_string_order                                                       \
+        )                                                                                                  \
+        {                                                                                                  \
+            matchable_define_register_variants_common                                                      \
+            by_index().insert(                                                                             \
+                by_index().end(),                                                                          \
+                std::make_move_iterator(variants.begin()),                                                 \
+                std::make_move_iterator(variants.end())                                                    \
+            );                                                                                             \
+        }                                                                                                  \
         inline std::vector<Type> const & variants_by_index() { return I##t::variants_by_index(); }         \
         inline Type from_index(int index)                                                                  \
         {                                                                                                  \
             if (index < 0 || index >= (int) I##t::all_variants_by_index()->size())                         \
                 return nil;                                                                                \
-            if (I##t::all_variants_by_index() != &I##t::variants_by_index())                               \
-                return from_string(I##t::all_variants_by_index()->at(index).as_string());                  \
-            return I##t::all_variants_by_index()->at(index);                                               \
+            Type const & v = (*I##t::all_variants_by_index())[index];                                      \
+            return ::matchable::VariantVisibility<Type>::instance().is_hidden(v) ? nil : v;                \
         }                                                                                                  \
     }
 #endif
@@ -635,22 +1194,16 @@ namespace matchable
             v() = default;                                                                                 \
             int as_by_string_index() const override { return *m_by_string_index(); }                       \
             std::string const & as_string() const override                                                 \
-            {                                                                                              \
-                static std::string const s =                                                               \
-                    [&]()                                                                                  \
-                    {                                                                                      \
-                        std::string s{#v};                                                                 \
-                        if (t::name == "escapable")                                                        \
-                            return s;                                                                      \
-                        return matchable::escapable::unescape_all(s);                                      \
-                    }();                                                                                   \
-                return s;                                                                                  \
-            }                                                                                              \
+                { static std::string const s{m_unescaped.view()}; return s; }                              \
+            /* as_string(), unescaped at compile time */                                                   \
+            static constexpr std::string_view as_string_view() { return m_unescaped.view(); }              \
             std::string const & as_identifier_string() const override                                      \
                 { static std::string const s{#v}; return s; }                                              \
             void set_by_string_index(int index) override { *m_by_string_index() = index; }                 \
             static Type grab() { return Type(create()); }                                                  \
             static int * m_by_string_index() { static int i{-1}; return &i; }                              \
+            static constexpr auto m_unescaped =                                                            \
+                ::matchable::escapable::unescape_literal(#v, std::string_view(#t) != "escapable");         \
         private:                                                                                           \
             std::shared_ptr<I##t> clone() const  override { return create(); }                             \
             static std::shared_ptr<v> create() { return std::make_shared<v>(); }
@@ -845,54 +1398,87 @@ namespace matchable
 #define matchable_type_property_amendment(pt, p, t)                                                        \
     public:                                                                                                \
         /* vector property */                                                                              \
-        std::vector<pt> const & as_##p##_vect() const                                                      \
-            { return nullptr == t ? T::nil_##p##_vect() : t->as_##p##_vect(); }                            \
-        std::vector<pt> & as_mutable_##p##_vect()                                                          \
-            { return nullptr == t ? T::nil_##p##_vect() : t->as_mutable_##p##_vect(); }                    \
+        std::span<pt const> as_##p##_vect() const                                                          \
+            { return nullptr == t ? std::span<pt const>(T::nil_##p##_vect()) : t->as_##p##_vect(); }       \
+        std::span<pt> as_mutable_##p##_vect()                                                              \
+            { if (nullptr != t) return t->as_mutable_##p##_vect();                                         \
+              T::modify_##p(); return T::nil_##p##_vect(); }                                               \
         void set_##p##_vect(std::vector<pt> const & v)                                                     \
-            { if (nullptr == t) { T::nil_##p##_vect() = v; for (auto f : T::nil_##p##_vect_obs()) f(); }   \
+            { if (nullptr == t)                                                                            \
+              { T::modify_##p(); T::nil_##p##_vect() = v;                                                  \
+                matchable::notify_observers({&T::nil_##p##_vect_obs(), -1}, T::nil_##p##_vect_obs()); }    \
               else t->set_##p##_vect(v); }                                                                 \
                                                                                                            \
         /* single property */                                                                              \
-        pt const & as_##p() const { return nullptr == t ? T::nil_##p() : t->as_##p(); }                    \
-        pt & as_mutable_##p() { return nullptr == t ? T::nil_##p() : t->as_mutable_##p(); }                \
+        pt const & as_##p() const                                                                          \
+            { if (is_##p##_constant()) return T::template p##_constants<>::values[as_##p##_table_index()]; \
+              return nullptr == t ? T::nil_##p() : t->as_##p(); }                                          \
+        pt & as_mutable_##p()                                                                              \
+            { if (is_##p##_constant()) ::matchable::frozen_property_modified(T::p##_property_name());      \
+              if (nullptr != t) return t->as_mutable_##p();                                                \
+              T::modify_##p(); return T::nil_##p(); }                                                      \
         void set_##p(pt const & s)                                                                         \
-            { if (nullptr == t) { T::nil_##p() = s; for (auto f : T::nil_##p##_obs()) f(); }               \
+            { if (is_##p##_constant()) ::matchable::frozen_property_modified(T::p##_property_name());      \
+              if (nullptr == t)                                                                            \
+              { T::modify_##p(); T::nil_##p() = s;                                                         \
+                matchable::notify_observers({&T::nil_##p##_obs(), -1}, T::nil_##p##_obs()); }              \
               else t->set_##p(s); }                                                                        \
+        /* true if this variant's value comes from a compile-time table (MATCHABLE_PROPERTY_CONSTANTS) */  \
+        bool is_##p##_constant() const                                                                     \
+            { if constexpr (T::template p##_constants<>::size == 0) return false;                          \
+              else return nullptr != t &&                                                                  \
+                          as_##p##_table_index() < (int) T::template p##_constants<>::size; }              \
                                                                                                            \
         /* observers */                                                                                    \
         void add_##p##_vect_observer(std::function<void ()> o)                                             \
-            { if (nullptr == t) T::nil_##p##_vect_obs().push_back(o);                                      \
+            { if (nullptr == t) { T::check_##p##_frozen(); T::nil_##p##_vect_obs().push_back(o); }         \
               else t->add_##p##_vect_observer(o); }                                                        \
         void add_##p##_observer(std::function<void ()> o)                                                  \
-            { if (nullptr == t) T::nil_##p##_obs().push_back(o); else t->add_##p##_observer(o); }
+            { if (nullptr == t) { T::check_##p##_frozen(); T::nil_##p##_obs().push_back(o); }              \
+              else t->add_##p##_observer(o); }                                                             \
+    private:                                                                                               \
+        int as_##p##_table_index() const { return ::matchable::property_table_index(*this); }
 
 
 #define matchable_declaration_property_amendment(pt, p, t)                                                 \
     public:                                                                                                \
         /* vector property */                                                                              \
-        std::vector<pt> const & as_##p##_vect() const { return p##_vect_mb().at(Type(clone())); }          \
-        std::vector<pt> & as_mutable_##p##_vect() { return p##_vect_mb().mut_at(Type(clone())); }          \
+        std::span<pt const> as_##p##_vect() const { return p##_vect_mb().at(Type(clone())); }              \
+        std::span<pt> as_mutable_##p##_vect()                                                              \
+            { modify_##p(); return p##_vect_mb().mut_at(Type(clone())); }                                  \
         void set_##p##_vect(std::vector<pt> const & v)                                                     \
-            { auto c = Type(clone()); p##_vect_mb().set(c, v);                                             \
-              for (auto f : p##_vect_obs_mb().at(c)) f(); }                                                \
+            { modify_##p(); auto c = Type(clone()); p##_vect_mb().set(c, v);                               \
+              matchable::notify_observers(                                                                 \
+                  {&p##_vect_obs_mb(), ::matchable::property_table_index(c)}, p##_vect_obs_mb().at(c)); }  \
                                                                                                            \
         /* single property */                                                                              \
         pt const & as_##p() const { return p##_mb().at(Type(clone())); }                                   \
-        pt & as_mutable_##p() { return p##_mb().mut_at(Type(clone())); }                                   \
+        pt & as_mutable_##p() { modify_##p(); return p##_mb().mut_at(Type(clone())); }                     \
         void set_##p(pt const & s)                                                                         \
-            { auto c = Type(clone()); p##_mb().set(c, s); for (auto f : p##_obs_mb().at(c)) f(); }         \
+            { modify_##p(); auto c = Type(clone()); p##_mb().set(c, s);                                    \
+              matchable::notify_observers(                                                                 \
+                  {&p##_obs_mb(), ::matchable::property_table_index(c)}, p##_obs_mb().at(c)); }            \
                                                                                                            \
         /* observers */                                                                                    \
         void add_##p##_vect_observer(std::function<void ()> f)                                             \
-            { p##_vect_obs_mb().mut_at(Type(clone())).push_back(f); }                                      \
+            { check_##p##_frozen(); p##_vect_obs_mb().mut_at(Type(clone())).push_back(f); }                \
         void add_##p##_observer(std::function<void ()> f)                                                  \
-            { p##_obs_mb().mut_at(Type(clone())).push_back(f); }                                           \
+            { check_##p##_frozen(); p##_obs_mb().mut_at(Type(clone())).push_back(f); }                     \
+                                                                                                           \
+        /* compile-time constant values, specialized by MATCHABLE_PROPERTY_CONSTANTS() */                  \
+        using p##_property_type = pt;                                                                      \
+        template<typename = void> struct p##_constants                                                     \
+            { static constexpr size_t size{0}; static constexpr pt const * values{nullptr}; };             \
+        static char const * p##_property_name() { return #t "::" #p; }                                     \
                                                                                                            \
     private:                                                                                               \
+        /* fail fast if modified after freeze() */                                                         \
+        static void check_##p##_frozen()                                                                   \
+            { if (is_frozen()) ::matchable::frozen_property_modified(p##_property_name()); }               \
+        static void modify_##p() { check_##p##_frozen(); ++generation_counter(); }                         \
         /* vector property for non-nil variants */                                                         \
-        static matchable::MatchBox<t::Type, std::vector<pt>> & p##_vect_mb()                               \
-            { static matchable::MatchBox<t::Type, std::vector<pt>> mb; return mb; }                        \
+        static matchable::SpanMatchBox<t::Type, pt> & p##_vect_mb()                                        \
+            { static matchable::SpanMatchBox<t::Type, pt> mb; return mb; }                                 \
         /* vector property for nil variant */                                                              \
         static std::vector<pt> & nil_##p##_vect() { static std::vector<pt> v; return v; }                  \
         /* observers of vector property for non-nil variants */                                            \
@@ -1592,7 +2178,7 @@ namespace matchable
 
 #define MATCHABLE_VARIANT_PROPERTY_VALUES(t, v, p, ...)                                                    \
     static bool const MATCHABLE_VARIANT_PROPERTY_VALUES_init_##t##_##v##_##p =                             \
-        [](decltype(t::v::grab().as_##p##_vect()) sv)                                                      \
+        [](std::vector<std::remove_cvref_t<decltype(t::v::grab().as_##p())>> const & sv)                   \
             { t::v::grab().set_##p##_##vect(sv); return true; }({__VA_ARGS__});
 
 
@@ -1602,10 +2188,30 @@ namespace matchable
 
 #define MATCHABLE_NIL_PROPERTY_VALUES(t, p, ...)                                                           \
     static bool const SET_PROPERTY_VECT_init_##t##_nil_##p =                                               \
-        [](decltype(t::nil.as_##p##_vect()) sv)                                                            \
+        [](std::vector<std::remove_cvref_t<decltype(t::nil.as_##p())>> const & sv)                         \
             { t::nil.set_##p##_##vect(sv); return true; }({__VA_ARGS__});
 
 
+// Declare the values of property p for the variants of t as a compile-time constant table
+//
+// Values are listed in variant index order (by string order when MATCHABLE_OMIT_BY_INDEX is defined) and
+// must be of a literal type. The table lives in read-only memory and costs nothing at startup. Variants
+// covered by the table can not be set (doing so aborts). Variants beyond the end of the table behave like
+// ordinary properties.
+//
+// The table is an explicit specialization that the property's accessors are compiled against, so it must
+// directly follow the definition of t in the same header, before anything uses the property. Translation
+// units not seeing it would compile the accessors without the table (an ODR violation that compilers need
+// not diagnose), and using it after the property was used is a specialization after instantiation error.
+#define MATCHABLE_PROPERTY_CONSTANTS(t, p, ...)                                                            \
+    template<> struct t::I##t::p##_constants<void>                                                         \
+    {                                                                                                      \
+        static constexpr p##_property_type storage[] = {__VA_ARGS__};                                      \
+        static constexpr size_t size{sizeof(storage) / sizeof(storage[0])};                                \
+        static constexpr p##_property_type const * values{storage};                                        \
+    };
+
+
 // Remove variants for the current scope (when the scope exits the removed variants are restored).
 #define UNMATCHABLE(t, ...)                                                                                \
     matchable::Unmatchable<t::Type> unm_##t{{mcv(matchable_concat_variant, t, ##__VA_ARGS__)}}
@@ -1661,43 +2267,43 @@ namespace matchable
         inline std::string unescape_all(std::string const & input);
         inline std::string escape_all(std::string const & input);
 
+        // Escape codes without their enclosing underscores, for example "spc" for "_spc_"
+        inline constexpr std::array<std::pair<std::string_view, char>, 32> codes{{
+            {"spc", ' '}, {"bng", '!'}, {"quot", '"'}, {"hsh", '#'}, {"dol", '$'}, {"pct", '%'},
+            {"und", '&'}, {"sqt", '\''}, {"parl", '('}, {"parr", ')'}, {"ast", '*'}, {"plus", '+'},
+            {"cma", ','}, {"mns", '-'}, {"dot", '.'}, {"slsh", '/'}, {"cln", ':'}, {"scln", ';'},
+            {"lt", '<'}, {"eq", '='}, {"gt", '>'}, {"qstn", '?'}, {"atsym", '@'}, {"sbl", '['},
+            {"bslsh", '\\'}, {"sbr", ']'}, {"dach", '^'}, {"bqt", '`'}, {"cbl", '{'}, {"pip", '|'},
+            {"cbr", '}'}, {"tld", '~'}
+        }};
+        inline constexpr size_t max_code_length{5};
+
+        // For each byte, 1 + its position within codes if it must be escaped, otherwise 0
+        inline constexpr std::array<unsigned char, 256> code_positions =
+            [](){
+                std::array<unsigned char, 256> positions{};
+                for (size_t i = 0; i < codes.size(); ++i)
+                    positions[static_cast<unsigned char>(codes[i].second)] =
+                            static_cast<unsigned char>(i + 1);
+                return positions;
+            }();
+
+        constexpr char symbol_of(std::string_view code)
+        {
+            for (auto const & [c, symbol] : codes)
+                if (c == code)
+                    return symbol;
+            return '\0';
+        }
+
+        // codes with their enclosing underscores paired with their symbols, for example ("_spc_", " ")
         inline std::vector<std::pair<std::string, std::string>> const & code_symbol_pairs()
         {
             static std::vector<std::pair<std::string, std::string>> const csp =
                 [](){
                     std::vector<std::pair<std::string, std::string>> csp_init;
-                    csp_init.push_back(std::make_pair("_spc_", " "));
-                    csp_init.push_back(std::make_pair("_bng_", "!"));
-                    csp_init.push_back(std::make_pair("_quot_", "\""));
-                    csp_init.push_back(std::make_pair("_hsh_", "#"));
-                    csp_init.push_back(std::make_pair("_dol_", "$"));
-                    csp_init.push_back(std::make_pair("_pct_", "%"));
-                    csp_init.push_back(std::make_pair("_und_", "&"));
-                    csp_init.push_back(std::make_pair("_sqt_", "'"));
-                    csp_init.push_back(std::make_pair("_parl_", "("));
-                    csp_init.push_back(std::make_pair("_parr_", ")"));
-                    csp_init.push_back(std::make_pair("_ast_", "*"));
-                    csp_init.push_back(std::make_pair("_plus_", "+"));
-                    csp_init.push_back(std::make_pair("_cma_", ","));
-                    csp_init.push_back(std::make_pair("_mns_", "-"));
-                    csp_init.push_back(std::make_pair("_dot_", "."));
-                    csp_init.push_back(std::make_pair("_slsh_", "/"));
-                    csp_init.push_back(std::make_pair("_cln_", ":"));
-                    csp_init.push_back(std::make_pair("_scln_", ";"));
-                    csp_init.push_back(std::make_pair("_lt_", "<"));
-                    csp_init.push_back(std::make_pair("_eq_", "="));
-                    csp_init.push_back(std::make_pair("_gt_", ">"));
-                    csp_init.push_back(std::make_pair("_qstn_", "?"));
-                    csp_init.push_back(std::make_pair("_atsym_", "@"));
-                    csp_init.push_back(std::make_pair("_sbl_", "["));
-                    csp_init.push_back(std::make_pair("_bslsh_", "\\"));
-                    csp_init.push_back(std::make_pair("_sbr_", "]"));
-                    csp_init.push_back(std::make_pair("_dach_", "^"));
-                    csp_init.push_back(std::make_pair("_bqt_", "`"));
-                    csp_init.push_back(std::make_pair("_cbl_", "{"));
-                    csp_init.push_back(std::make_pair("_pip_", "|"));
-                    csp_init.push_back(std::make_pair("_cbr_", "}"));
-                    csp_init.push_back(std::make_pair("_tld_", "~"));
+                    for (auto const & [code, symbol] : codes)
+                        csp_init.emplace_back("_" + std::string(code) + "_", std::string(1, symbol));
                     return csp_init;
                 }();
             return csp;
@@ -1705,41 +2311,77 @@ namespace matchable
 
         inline std::string unescape(std::string const & esc)
         {
-            if (esc.size() == 0)
-                return "";
-
-            for (auto const & [code, symbol] : code_symbol_pairs())
-                if (code == esc)
-                    return symbol;
+            if (esc.size() > 2 && esc.front() == '_' && esc.back() == '_')
+            {
+                char const symbol = symbol_of(std::string_view(esc).substr(1, esc.size() - 2));
+                if (symbol != '\0')
+                    return std::string(1, symbol);
+            }
 
             return esc;
         }
 
 
-        inline std::string unescape_all(std::string const & input)
+        // Decode input in a single left to right pass, passing each resulting character to append.
+        // Codes contain no underscores other than their delimiters, so at most one code can start at any
+        // underscore and looking ahead max_code_length + 1 characters is enough to recognize it.
+        template<typename F>
+        constexpr void unescape_each(std::string_view input, F append)
         {
-            std::string unescaped{input};
-            if (unescaped.substr(0, 4) == "esc_")
-                unescaped.erase(0, 4);
+            if (input.substr(0, 4) == "esc_")
+                input.remove_prefix(4);
 
-            size_t index = 0;
-            for (auto const & [code, symbol] : code_symbol_pairs())
+            size_t i = 0;
+            while (i < input.size())
             {
-                index = 0;
-                while (true)
+                if (input[i] == '_')
                 {
-                    index = unescaped.find(code, index);
-                    if (index == std::string::npos)
-                        break;
-
-                    auto replacement = symbol;
-                    assert(replacement != "");
-                    unescaped.erase(index, code.size());
-                    unescaped.insert(index, replacement);
-                    index += replacement.size();
+                    size_t const close = input.substr(i + 1, max_code_length + 1).find('_');
+                    if (close != std::string_view::npos)
+                    {
+                        char const symbol = symbol_of(input.substr(i + 1, close));
+                        if (symbol != '\0')
+                        {
+                            append(symbol);
+                            i += close + 2;
+                            continue;
+                        }
+                    }
                 }
+                append(input[i]);
+                ++i;
             }
+        }
+
+
+        // Fixed capacity string holding the result of unescaping a string literal at compile time
+        template<size_t N>
+        struct UnescapedLiteral
+        {
+            std::array<char, N> chars{};
+            size_t size{0};
+            constexpr std::string_view view() const { return std::string_view(chars.data(), size); }
+        };
+
+        template<size_t N>
+        constexpr UnescapedLiteral<N> unescape_literal(char const (&input)[N], bool unescape = true)
+        {
+            UnescapedLiteral<N> ret;
+            auto append = [&ret](char c) { ret.chars[ret.size++] = c; };
+            if (unescape)
+                unescape_each(std::string_view(input, N - 1), append);
+            else
+                for (size_t i = 0; i + 1 < N; ++i)
+                    append(input[i]);
+            return ret;
+        }
 
+
+        inline std::string unescape_all(std::string const & input)
+        {
+            std::string unescaped;
+            unescaped.reserve(input.size());
+            unescape_each(input, [&unescaped](char c) { unescaped.push_back(c); });
             return unescaped;
         }
 
@@ -1749,68 +2391,181 @@ namespace matchable
             if (str.size() != 1)
                 return str;
 
-            static int const offset{32};
-            static std::array<std::string, 128 - offset> const escapables =
-                [&](){
-                    std::array<std::string, 128 - offset> e;
-
-                    for (int i = 0; i < (int) e.size(); ++i)
-                        e[i] = std::string(1, (char) (i + offset));
-
-                    e[(int) ' ' - offset] = "_spc_";
-                    e[(int) '!' - offset] = "_bng_";
-                    e[(int) '"' - offset] = "_quot_";
-                    e[(int) '#' - offset] = "_hsh_";
-                    e[(int) '$' - offset] = "_dol_";
-                    e[(int) '%' - offset] = "_pct_";
-                    e[(int) '&' - offset] = "_und_";
-                    e[(int) '\'' - offset] = "_sqt_";
-                    e[(int) '(' - offset] = "_parl_";
-                    e[(int) ')' - offset] = "_parr_";
-                    e[(int) '*' - offset] = "_ast_";
-                    e[(int) '+' - offset] = "_plus_";
-                    e[(int) ',' - offset] = "_cma_";
-                    e[(int) '-' - offset] = "_mns_";
-                    e[(int) '.' - offset] = "_dot_";
-                    e[(int) '/' - offset] = "_slsh_";
-                    e[(int) ':' - offset] = "_cln_";
-                    e[(int) ';' - offset] = "_scln_";
-                    e[(int) '<' - offset] = "_lt_";
-                    e[(int) '=' - offset] = "_eq_";
-                    e[(int) '>' - offset] = "_gt_";
-                    e[(int) '?' - offset] = "_qstn_";
-                    e[(int) '@' - offset] = "_atsym_";
-                    e[(int) '[' - offset] = "_sbl_";
-                    e[(int) '\\' - offset] = "_bslsh_";
-                    e[(int) ']' - offset] = "_sbr_";
-                    e[(int) '^' - offset] = "_dach_";
-                    e[(int) '`' - offset] = "_bqt_";
-                    e[(int) '{' - offset] = "_cbl_";
-                    e[(int) '|' - offset] = "_pip_";
-                    e[(int) '}' - offset] = "_cbr_";
-                    e[(int) '~' - offset] = "_tld_";
-                    return e;
-                }();
-
-            int const & ch = str[0];
-            if (ch >= offset && ch < 127)
-                return escapables[ch - offset];
+            unsigned char const position = code_positions[static_cast<unsigned char>(str[0])];
+            if (position == 0)
+                return str;
 
-            return str;
+            return "_" + std::string(codes[position - 1].first) + "_";
         }
 
 
-        inline std::string escape_all(std::string const & input)
+        // Append the escaped input to out, copying runs of characters that need no escaping all at once
+        inline void escape_all(std::string_view input, std::string & out)
         {
-            std::string escaped;
-            std::string escapable;
-            std::string char_as_str;
+            out.reserve(out.size() + input.size());
+            size_t run_begin = 0;
             for (size_t i = 0; i < input.size(); ++i)
             {
-                char_as_str = std::string(1, input[i]);
-                escaped += escapable::escape(char_as_str);
+                unsigned char const position = code_positions[static_cast<unsigned char>(input[i])];
+                if (position == 0)
+                    continue;
+
+                out.append(input.data() + run_begin, i - run_begin);
+                out += '_';
+                out += codes[position - 1].first;
+                out += '_';
+                run_begin = i + 1;
             }
+            out.append(input.data() + run_begin, input.size() - run_begin);
+        }
+
+
+        inline std::string escape_all(std::string const & input)
+        {
+            std::string escaped;
+            escape_all(std::string_view(input), escaped);
             return escaped;
         }
     }
 }
+
+
+namespace matchable
+{
+    // Variant registered from a table (see register_variant_table()) instead of being a class of its own
+    template<typename I>
+    class TableVariant : public I
+    {
+    public:
+        struct Entry
+        {
+            std::string identifier;
+            std::string string;
+            int by_string_index{-1};
+            int index{-1};
+        };
+
+        explicit TableVariant(Entry * e) : entry{e} {}
+        int as_by_string_index() const override { return entry->by_string_index; }
+        std::string const & as_string() const override { return entry->string; }
+        std::string const & as_identifier_string() const override { return entry->identifier; }
+#ifndef MATCHABLE_OMIT_BY_INDEX
+        int as_index() const override { return entry->index; }
+#endif
+
+    private:
+        void set_by_string_index(int index) override { entry->by_string_index = index; }
+        std::shared_ptr<I> clone() const override { return std::make_shared<TableVariant>(entry); }
+
+        Entry * entry;
+    };
+
+
+    // Grow matchable type M by the variants named by identifiers (escaped as for GROW_MATCHABLE()), all
+    // registered at once and without a class per variant, so there is no t::v to grab() (use
+    // from_string()). by_string_order optionally lists the positions of identifiers sorted by string,
+    // saving a sort at startup (an invalid order is ignored). Returns the new variants in table order.
+    template<typename M>
+    std::vector<M> register_variant_table(
+        std::span<std::string_view const> identifiers,
+        std::span<int const> by_string_order = {}
+    )
+    {
+        using I = typename M::interface_type;
+        using Entry = typename TableVariant<I>::Entry;
+        static std::deque<Entry> entries;
+
+#ifdef MATCHABLE_OMIT_BY_INDEX
+        int const first_index{-1};
+#else
+        int const first_index = static_cast<int>(I::all_variants_by_index()->size());
+#endif
+        std::vector<M> variants;
+        variants.reserve(identifiers.size());
+        for (auto identifier : identifiers)
+        {
+            Entry & e = entries.emplace_back();
+            e.identifier = identifier;
+            e.string.reserve(identifier.size());
+            escapable::unescape_each(identifier, [&e](char c) { e.string.push_back(c); });
+            if (first_index != -1)
+                e.index = first_index + static_cast<int>(variants.size());
+            variants.push_back(M(std::make_shared<TableVariant<I>>(&e)));
+        }
+
+        auto lt = [&variants](int a, int b) { return variants[a].lt_by_string(variants[b]); };
+        std::vector<int> order(by_string_order.begin(), by_string_order.end());
+        bool valid = order.size() == variants.size();
+        std::vector<bool> seen(valid ? order.size() : 0, false);
+        for (size_t i = 0; valid && i < order.size(); ++i)
+        {
+            valid = order[i] >= 0 && order[i] < (int) order.size() && !seen[order[i]] &&
+                    (i == 0 || !lt(order[i], order[i - 1]));
+            if (valid)
+                seen[order[i]] = true;
+        }
+        if (!valid)
+        {
+            order.resize(variants.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), lt);
+        }
+
+        I::register_variants(std::vector<M>(variants), order);
+        return variants;
+    }
+
+
+    // Generated tables list identifiers as plain string literals, as initializing millions of string_views
+    // in a constant expression exceeds what compilers are willing to evaluate
+    template<typename M>
+    std::vector<M> register_variant_table(
+        std::span<char const * const> identifiers,
+        std::span<int const> by_string_order = {}
+    )
+    {
+        std::vector<std::string_view> const views(identifiers.begin(), identifiers.end());
+        return register_variant_table<M>(std::span<std::string_view const>{views}, by_string_order);
+    }
+
+
+    // Set a property of table variants from parallel arrays, calling set(variant, values[value_indexes[i]])
+    // for the variant at positions[i] (values holds each distinct value once)
+    template<typename M, typename P, typename X, typename V, typename F>
+    bool set_property_column(
+        std::vector<M> const & variants,
+        P const & positions,
+        X const & value_indexes,
+        V const & values,
+        F set
+    )
+    {
+        for (size_t i = 0; i < std::size(positions); ++i)
+            set(variants[positions[i]], values[value_indexes[i]]);
+        return true;
+    }
+
+
+    // Set a vector property of table variants, the values of the variant at positions[i] are those at
+    // value_indexes [offsets[i], offsets[i + 1])
+    template<typename M, typename P, typename O, typename X, typename V, typename F>
+    bool set_property_vect_column(
+        std::vector<M> const & variants,
+        P const & positions,
+        O const & offsets,
+        X const & value_indexes,
+        V const & values,
+        F set
+    )
+    {
+        std::vector<std::remove_cvref_t<decltype(values[0])>> variant_values;
+        for (size_t i = 0; i < std::size(positions); ++i)
+        {
+            variant_values.clear();
+            for (int j = offsets[i]; j < offsets[i + 1]; ++j)
+                variant_values.push_back(values[value_indexes[j]]);
+            set(variants[positions[i]], variant_values);
+        }
+        return true;
+    }
+}
@@ -1,9 +1,28 @@
 #include <matchable/MatchableMaker.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <map>
 #include <iostream>
+#include <istream>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <matchable/matchable.h>
 
@@ -11,61 +30,147 @@
 
 namespace matchable
 {
+    std::string_view StringPool::intern(std::string_view s)
+    {
+        auto it = interned.find(s);
+        if (it != interned.end())
+            return *it;
+
+        return *interned.insert(copy(s)).first;
+    }
+
+
+    std::string_view StringPool::copy(std::string_view s)
+    {
+        char * copied = static_cast<char *>(arena.allocate(s.size() == 0 ? 1 : s.size(), 1));
+        std::copy(s.begin(), s.end(), copied);
+        return std::string_view{copied, s.size()};
+    }
+
+
+
+    Matchable::Matchable()
+        : own_pool{std::make_unique<StringPool>()}
+        , pool{own_pool.get()}
+        , variants{pool->node_resource()}
+        , variant_positions{pool->node_resource()}
+        , sorted_variant_names{pool->node_resource()}
+        , property_ids{pool->node_resource()}
+    {
+        touch();
+    }
+
+
+    Matchable::Matchable(StringPool * pool)
+        : pool{pool}
+        , variants{pool->node_resource()}
+        , variant_positions{pool->node_resource()}
+        , sorted_variant_names{pool->node_resource()}
+        , property_ids{pool->node_resource()}
+    {
+        touch();
+    }
+
+
     void Matchable::add_variant(std::string const & variant_name)
     {
-        if (std::find(variants.begin(), variants.end(), variant_name) == variants.end())
-        {
-            MatchableVariant v;
-            v.variant_name = variant_name;
-            variants.push_back(v);
-        }
+        add_or_find_variant(variant_name);
+    }
+
+
+    size_t Matchable::add_or_find_variant(std::string const & variant_name)
+    {
+        int const position = variant_position(variant_name);
+        if (position != -1)
+            return position;
+
+        touch();
+        variants.emplace_back(variant_name);
+        std::string_view const copied = pool->copy(variant_name);
+        variant_positions.insert({copied, variants.size() - 1});
+        sorted_variant_names.insert(copied);
+        return variants.size() - 1;
     }
 
 
     void Matchable::del_variant(std::string const & variant_name)
     {
-        auto variant_iter = std::find_if(
-            variants.begin(),
-            variants.end(),
-            [&](auto const & s) { return s.variant_name == variant_name; }
-        );
+        int const position = variant_position(variant_name);
+        if (position == -1)
+            return;
 
-        if (variant_iter != variants.end())
-            variants.erase(variant_iter);
+        touch();
+        variants.erase(variants.begin() + position);
+        variant_positions.erase(variant_name);
+        if (auto sorted = sorted_variant_names.find(variant_name); sorted != sorted_variant_names.end())
+            sorted_variant_names.erase(sorted);
+        for (size_t i = position; i < variants.size(); ++i)
+            variant_positions.find(variants[i].variant_name)->second = i;
     }
 
 
     void Matchable::variants_starting_with(std::string const & prefix, std::vector<std::string> & result)
     {
         result.clear();
-        for (auto const & v : variants)
+        auto [begin, end] = variants_with_prefix(prefix);
+        result.assign(begin, end);
+
+        // keep declaration order
+        std::sort(
+            result.begin(),
+            result.end(),
+            [&](auto const & a, auto const & b) { return variant_positions.at(a) < variant_positions.at(b); }
+        );
+    }
+
+
+    std::pair<Matchable::variant_name_iterator, Matchable::variant_name_iterator>
+    Matchable::variants_with_prefix(std::string const & prefix)
+    {
+        sync_variant_indexes();
+        auto begin = sorted_variant_names.lower_bound(prefix);
+
+        // the range ends at the first name not less than the smallest string greater than every string
+        // starting with prefix
+        std::string after_prefix{prefix};
+        while (!after_prefix.empty() && (unsigned char) after_prefix.back() == 0xff)
+            after_prefix.pop_back();
+        variant_name_iterator end = sorted_variant_names.end();
+        if (!after_prefix.empty())
         {
-            if (v.variant_name.size() < prefix.size())
-                continue;
+            ++after_prefix.back();
+            end = sorted_variant_names.lower_bound(after_prefix);
+        }
 
-            if (prefix == v.variant_name.substr(0, prefix.size()))
-                result.push_back(v.variant_name);
+        // as with variant_position(), a name no longer found at its indexed position means variants was
+        // modified directly
+        for (auto it = begin; it != end; ++it)
+        {
+            size_t const position = variant_positions.find(*it)->second;
+            if (position >= variants.size() || variants[position].variant_name != *it)
+            {
+                rebuild_variant_indexes();
+                return variants_with_prefix(prefix);
+            }
         }
+        return {begin, end};
     }
 
 
     bool Matchable::has_variant(std::string const & variant_name)
     {
-        return std::find_if(
-            variants.begin(),
-            variants.end(),
-            [&](auto const & s) { return s.variant_name == variant_name; }
-        ) != variants.end();
+        return variant_position(variant_name) != -1;
     }
 
 
     bool Matchable::add_property(std::string const & property_type, std::string const & property_name)
     {
-        for (auto const & [type, name] : property_types_and_names)
-            if (name == property_name)
-                return false;
+        if (property_id(property_name) != -1)
+            return false;
 
+        touch();
         property_types_and_names.push_back(std::make_pair(property_type, property_name));
+        property_ids.insert({pool->intern(property_name), property_types_and_names.size() - 1});
         return true;
     }
 
@@ -76,22 +181,17 @@ namespace matchable
         std::string const & value
     )
     {
-        std::vector<MatchableVariant>::iterator iter;
+        std::pmr::vector<MatchableVariant>::iterator iter;
+        size_t id;
         set_property_status::Type ret =
-                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter);
+                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter, id);
         if (ret != set_property_status::success::grab())
             return ret;
 
-        auto property_iter = std::find_if(
-            iter->properties.begin(),
-            iter->properties.end(),
-            [&](auto const & s) { return std::get<0>(s) == property_name; }
-        );
-
-        if (property_iter != iter->properties.end())
-            std::get<1>(*property_iter) = value;
-        else
-            iter->properties.push_back(std::make_tuple(property_name, value, std::vector<std::string>{}));
+        touch();
+        if (iter->properties.size() <= id)
+            iter->properties.resize(id + 1);
+        iter->properties[id].value = value;
 
         return ret;
     }
@@ -103,22 +203,17 @@ namespace matchable
         std::vector<std::string> const & values
     )
     {
-        std::vector<MatchableVariant>::iterator iter;
+        std::pmr::vector<MatchableVariant>::iterator iter;
+        size_t id;
         set_property_status::Type ret =
-                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter);
+                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter, id);
         if (ret != set_property_status::success::grab())
             return ret;
 
-        auto property_iter = std::find_if(
-            iter->properties.begin(),
-            iter->properties.end(),
-            [&](auto const & s) { return std::get<0>(s) == property_name; }
-        );
-
-        if (property_iter != iter->properties.end())
-            std::get<2>(*property_iter) = values;
-        else
-            iter->properties.push_back(std::make_tuple(property_name, "", values));
+        touch();
+        if (iter->properties.size() <= id)
+            iter->properties.resize(id + 1);
+        iter->properties[id].values.assign(values.begin(), values.end());
 
         return ret;
     }
@@ -130,20 +225,15 @@ namespace matchable
         std::string & property_value
     )
     {
-        std::vector<MatchableVariant>::iterator iter;
+        std::pmr::vector<MatchableVariant>::iterator iter;
+        size_t id;
         set_property_status::Type ret =
-                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter);
+                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter, id);
         if (ret != set_property_status::success::grab())
             return;
 
-        auto property_iter = std::find_if(
-            iter->properties.begin(),
-            iter->properties.end(),
-            [&](auto const & s) { return std::get<0>(s) == property_name; }
-        );
-
-        if (property_iter != iter->properties.end())
-            property_value = std::get<1>(*property_iter);
+        if (id < iter->properties.size() && iter->properties[id].is_set())
+            property_value = iter->properties[id].value;
     }
 
 
@@ -154,55 +244,147 @@ namespace matchable
         std::vector<std::string> & property_values
     )
     {
-        std::vector<MatchableVariant>::iterator iter;
+        std::pmr::vector<MatchableVariant>::iterator iter;
+        size_t id;
         set_property_status::Type ret =
-                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter);
+                verify_property_and_variant__and__get_variant_iter(property_name, variant_name, iter, id);
         if (ret != set_property_status::success::grab())
         {
             std::cout << "verify failed with: " << ret << std::endl;
             return;
         }
 
-        auto property_iter = std::find_if(
-            iter->properties.begin(),
-            iter->properties.end(),
-            [&](auto const & s) { return std::get<0>(s) == property_name; }
-        );
-
-        if (property_iter != iter->properties.end())
-            property_values = std::get<2>(*property_iter);
+        if (id < iter->properties.size() && iter->properties[id].is_set())
+            property_values.assign(iter->properties[id].values.begin(), iter->properties[id].values.end());
     }
 
 
     set_property_status::Type Matchable::verify_property_and_variant__and__get_variant_iter(
         std::string const & property,
         std::string const & variant,
-        std::vector<MatchableVariant>::iterator & iter
+        std::pmr::vector<MatchableVariant>::iterator & iter,
+        size_t & property_id
     )
     {
         // verify property exists (has been added by add_property())
-        {
-            auto t_and_n_iter = std::find_if(
-                property_types_and_names.begin(),
-                property_types_and_names.end(),
-                [&](auto const & t_and_n) { return t_and_n.second == property; }
-            );
-            if (t_and_n_iter == property_types_and_names.end())
-                return set_property_status::property_lookup_failed::grab();
-        }
+        int const id = this->property_id(property);
+        if (id == -1)
+            return set_property_status::property_lookup_failed::grab();
 
-        auto variant_iter = std::find(variants.begin(), variants.end(), variant);
+        int const position = variant_position(variant);
 
         // verify add_variant() called for given variant
-        if (variant_iter == variants.end())
+        if (position == -1)
             return set_property_status::variant_lookup_failed::grab();
 
-        // only change iter on success
-        iter = variant_iter;
+        // only change iter and property_id on success
+        iter = variants.begin() + position;
+        property_id = id;
         return set_property_status::success::grab();
     }
 
 
+    int Matchable::property_id(std::string_view property_name)
+    {
+        // property_types_and_names is public, so detect direct modification and rebuild the index when needed
+        auto rebuild =
+            [&]()
+            {
+                property_ids.clear();
+                for (size_t i = 0; i < property_types_and_names.size(); ++i)
+                    property_ids.insert({pool->intern(property_types_and_names[i].second), i});
+            };
+        if (property_ids.size() != property_types_and_names.size())
+            rebuild();
+
+        auto it = property_ids.find(property_name);
+        if (it != property_ids.end())
+        {
+            if (it->second < property_types_and_names.size() &&
+                    property_types_and_names[it->second].second == property_name)
+                return static_cast<int>(it->second);
+            rebuild();
+            it = property_ids.find(property_name);
+            return it == property_ids.end() ? -1 : static_cast<int>(it->second);
+        }
+        return -1;
+    }
+
+
+    int Matchable::variant_position(std::string_view variant_name)
+    {
+        sync_variant_indexes();
+
+        auto it = variant_positions.find(variant_name);
+        if (it != variant_positions.end())
+        {
+            if (it->second < variants.size() && variants[it->second].variant_name == variant_name)
+                return static_cast<int>(it->second);
+            rebuild_variant_indexes();
+            it = variant_positions.find(variant_name);
+            return it == variant_positions.end() ? -1 : static_cast<int>(it->second);
+        }
+        return -1;
+    }
+
+
+    int Matchable::variant_position(std::string_view variant_name, size_t likely_position)
+    {
+        if (likely_position < variants.size() && variants[likely_position].variant_name == variant_name)
+            return static_cast<int>(likely_position);
+        return variant_position(variant_name);
+    }
+
+
+    void Matchable::sync_variant_indexes()
+    {
+        // variants is public, so detect direct modification and rebuild the indexes when needed
+        if (variant_positions.size() != variants.size())
+            rebuild_variant_indexes();
+    }
+
+
+    void Matchable::rebuild_variant_indexes()
+    {
+        touch();
+
+        // names already indexed keep their copies, so that only names new to the indexes are copied
+        std::pmr::unordered_map<std::string_view, size_t> previous{std::move(variant_positions)};
+        variant_positions.clear();
+        variant_positions.reserve(variants.size());
+        sorted_variant_names.clear();
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            auto const indexed = previous.find(variants[i].variant_name);
+            std::string_view const copied =
+                    indexed != previous.end() ? indexed->first : pool->copy(variants[i].variant_name);
+            variant_positions.insert({copied, i});
+            sorted_variant_names.insert(copied);
+        }
+    }
+
+
+
+    void Matchable::replace(
+        std::vector<std::pair<std::string, std::string>> && new_property_types_and_names,
+        std::pmr::vector<MatchableVariant> && new_variants
+    )
+    {
+        property_types_and_names = std::move(new_property_types_and_names);
+        variants = std::move(new_variants);
+        property_ids.clear();
+        rebuild_variant_indexes();
+    }
+
+
+
+    void Matchable::touch()
+    {
+        static std::atomic<uint64_t> revision_counter{0};
+        revision = ++revision_counter;
+    }
+
+
 
     MatchableMaker::MatchableMaker()
     {
@@ -211,26 +393,283 @@ namespace matchable
 
     MatchableMaker::~MatchableMaker()
     {
+        // memory is released with the pool
         for (auto & [n, m] : matchables)
-            delete m;
+            destroy_matchable(m);
 
         matchables.clear();
     }
 
 
+    Matchable * MatchableMaker::new_matchable(std::string const & name)
+    {
+        std::pmr::polymorphic_allocator<Matchable> allocator{pool.resource()};
+        Matchable * m = allocator.new_object<Matchable>(&pool);
+        m->name = name;
+        return m;
+    }
+
+
+    void MatchableMaker::destroy_matchable(Matchable * m)
+    {
+        std::destroy_at(m);
+    }
+
+
     Matchable * MatchableMaker::grab(std::string const & m)
     {
         auto lb = matchables.lower_bound(m);
         if (lb != matchables.end() && !(matchables.key_comp()(m, lb->first)))
             return lb->second;
 
-        Matchable * new_m = new Matchable;
-        new_m->name = m;
+        Matchable * new_m = new_matchable(m);
         matchables.insert(lb, std::make_pair(m, new_m));
         return new_m;
     }
 
 
+    // write the concatenation of parts
+    static bool write_file(std::string const & filename, std::vector<std::string_view> const & parts)
+    {
+        FILE * f = fopen(filename.c_str(), "wb");
+        if (nullptr == f)
+            return false;
+
+        bool ok{true};
+        for (auto part : parts)
+            ok = ok && fwrite(part.data(), 1, part.size(), f) == part.size();
+        return fclose(f) == 0 && ok;
+    }
+
+
+    static bool write_file(std::string const & filename, std::string const & contents)
+    {
+        return write_file(filename, std::vector<std::string_view>{contents});
+    }
+
+
+    // call f(i) for each i in [0, count), spread across the available hardware threads
+    template<typename F>
+    static void for_each_index_in_parallel(size_t count, F f)
+    {
+        size_t const hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t const worker_count = std::min(count, hardware_threads);
+        if (worker_count <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+                f(i);
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        auto work =
+            [&]()
+            {
+                for (size_t i = next++; i < count; i = next++)
+                    f(i);
+            };
+        std::vector<std::thread> workers;
+        workers.reserve(worker_count - 1);
+        for (size_t w = 1; w < worker_count; ++w)
+            workers.emplace_back(work);
+        work();
+        for (auto & w : workers)
+            w.join();
+    }
+
+
+    // the matchable within this maker that a property type refers to, or nullptr
+    static Matchable const * matchable_dependency(
+        std::map<std::string, Matchable *> const & matchables,
+        std::string const & property_type
+    )
+    {
+        static std::string const matchable_type_ending{"::Type"};
+        if (property_type.size() <= matchable_type_ending.size() ||
+                property_type.compare(
+                    property_type.size() - matchable_type_ending.size(),
+                    matchable_type_ending.size(),
+                    matchable_type_ending
+                ) != 0)
+            return nullptr;
+
+        auto it = matchables.find(
+            property_type.substr(0, property_type.size() - matchable_type_ending.size())
+        );
+        return it == matchables.end() ? nullptr : it->second;
+    }
+
+
+    // table variants have no classes to grab(), so a value of the form "t::v::grab()" is printed as a
+    // lookup by string instead (other values are printed as they are)
+    static void print_table_value(std::string_view value, std::string & out)
+    {
+        static std::string const grab_ending{"::grab()"};
+        size_t const first = value.find("::");
+        bool const is_grab =
+            value.size() > grab_ending.size() &&
+            value.compare(value.size() - grab_ending.size(), grab_ending.size(), grab_ending) == 0 &&
+            first != std::string_view::npos && first + 2 < value.size() - grab_ending.size() &&
+            value.find("::", first + 2) == value.size() - grab_ending.size() &&
+            std::all_of(
+                value.begin(),
+                value.end() - grab_ending.size(),
+                [](char c) { return c == ':' || c == '_' || std::isalnum((unsigned char) c); }
+            );
+        if (!is_grab)
+        {
+            out += value;
+            return;
+        }
+
+        out += value.substr(0, first);
+        out += "::from_string(\"";
+        std::string const variant{value.substr(first + 2, value.size() - grab_ending.size() - first - 2)};
+        for (char c : escapable::unescape_all(variant))
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        out += "\")";
+    }
+
+
+    bool MatchableMaker::order_by_dependencies(std::vector<Matchable const *> & ordered)
+    {
+        // Kahn's algorithm over the graph of property dependencies between matchables
+        struct Dependency
+        {
+            size_t dependent;
+            size_t dependency;
+            std::string const * property_name;
+        };
+        std::vector<Matchable const *> nodes;
+        std::unordered_map<Matchable const *, size_t> node_of;
+        nodes.reserve(matchables.size());
+        node_of.reserve(matchables.size());
+        for (auto const & [name, m] : matchables)
+        {
+            node_of.insert({m, nodes.size()});
+            nodes.push_back(m);
+        }
+
+        std::vector<Dependency> dependencies;
+        std::vector<std::vector<size_t>> dependents_of(nodes.size());
+        std::vector<size_t> unordered_dependency_count(nodes.size(), 0);
+        for (size_t n = 0; n < nodes.size(); ++n)
+        {
+            for (auto const & [p_type, p_name] : nodes[n]->property_types_and_names)
+            {
+                // self dependencies are fine since everything is forward declared, as are
+                // dependencies to matchables not within this maker
+                Matchable const * dependency = matchable_dependency(matchables, p_type);
+                if (nullptr == dependency || dependency == nodes[n])
+                    continue;
+
+                size_t const d = node_of[dependency];
+                dependencies.push_back({n, d, &p_name});
+                dependents_of[d].push_back(n);
+                ++unordered_dependency_count[n];
+            }
+        }
+
+        ordered.clear();
+        ordered.reserve(nodes.size());
+        std::vector<size_t> ready;
+        ready.reserve(nodes.size());
+        for (size_t n = 0; n < nodes.size(); ++n)
+            if (unordered_dependency_count[n] == 0)
+                ready.push_back(n);
+
+        for (size_t r = 0; r < ready.size(); ++r)
+        {
+            ordered.push_back(nodes[ready[r]]);
+            for (auto dependent : dependents_of[ready[r]])
+                if (--unordered_dependency_count[dependent] == 0)
+                    ready.push_back(dependent);
+        }
+
+        if (ordered.size() == nodes.size())
+            return true;
+
+        // Whatever could not be ordered depends (directly or indirectly) on a cycle. Cycles are the edges
+        // within strongly connected components of what is left, found with Tarjan's algorithm (iterative,
+        // so that long dependency chains do not overflow the stack).
+        auto const unordered = [&](size_t n) { return unordered_dependency_count[n] > 0; };
+        std::vector<std::vector<size_t>> edges_of(nodes.size());
+        for (size_t e = 0; e < dependencies.size(); ++e)
+            if (unordered(dependencies[e].dependent) && unordered(dependencies[e].dependency))
+                edges_of[dependencies[e].dependent].push_back(e);
+
+        size_t constexpr unvisited{static_cast<size_t>(-1)};
+        std::vector<size_t> index(nodes.size(), unvisited);
+        std::vector<size_t> low(nodes.size(), unvisited);
+        std::vector<size_t> component(nodes.size(), unvisited);
+        std::vector<size_t> visiting;
+        // node and the position of its next edge to follow
+        std::vector<std::pair<size_t, size_t>> path;
+        size_t next_index{0};
+        auto visit =
+            [&](size_t n)
+            {
+                index[n] = low[n] = next_index++;
+                visiting.push_back(n);
+                path.push_back({n, 0});
+            };
+        for (size_t root = 0; root < nodes.size(); ++root)
+        {
+            if (!unordered(root) || index[root] != unvisited)
+                continue;
+
+            visit(root);
+            while (!path.empty())
+            {
+                size_t const n = path.back().first;
+                if (path.back().second < edges_of[n].size())
+                {
+                    size_t const d = dependencies[edges_of[n][path.back().second++]].dependency;
+                    if (index[d] == unvisited)
+                        visit(d);
+                    else if (component[d] == unvisited)
+                        low[n] = std::min(low[n], index[d]);
+                    continue;
+                }
+
+                path.pop_back();
+                if (!path.empty())
+                    low[path.back().first] = std::min(low[path.back().first], low[n]);
+                if (low[n] == index[n])
+                {
+                    size_t member;
+                    do
+                    {
+                        member = visiting.back();
+                        visiting.pop_back();
+                        component[member] = n;
+                    } while (member != n);
+                }
+            }
+        }
+
+        std::vector<bool> in_cycle(nodes.size(), false);
+        std::cout << "WARNING! cyclic dependencies detected and omitted!" << std::endl;
+        for (auto const & d : dependencies)
+        {
+            if (!unordered(d.dependent) || !unordered(d.dependency) ||
+                    component[d.dependent] != component[d.dependency])
+                continue;
+            in_cycle[d.dependent] = true;
+            std::cout << "    " << nodes[d.dependent]->name << "::" << *d.property_name
+                      << " depends on " << nodes[d.dependency]->name << std::endl;
+        }
+        for (size_t n = 0; n < nodes.size(); ++n)
+            if (unordered(n) && !in_cycle[n])
+                std::cout << "    " << nodes[n]->name << " omitted as it depends on a cycle" << std::endl;
+        return false;
+    }
+
+
     save__status::Type MatchableMaker::save_as(
         std::string const & filename,
         save__content::Flags const & content,
@@ -243,75 +682,31 @@ namespace matchable
         if (mode.is_nil())
             return save__status::no_grow_mode::grab();
 
-        FILE * f = fopen(filename.c_str(), "w");
-        if (nullptr == f)
-            return save__status::io_error::grab();
-
         save__status::Type ret{save__status::success::grab()};
 
-        if (fputs("#pragma once\n\n\n#include <matchable/matchable.h>\n"
-                  "#include <matchable/matchable_fwd.h>\n\n\n\n", f) == EOF)
-            goto save_io_error;
+        std::string out{
+            "#pragma once\n\n\n#include <matchable/matchable.h>\n"
+            "#include <matchable/matchable_fwd.h>\n\n\n\n"
+        };
 
         // if we need matchable 'generated_matchable' with variants for each matchable in the maker
         if (content.is_set(save__content::generated_matchable::grab()))
-        {
-            if (mode == save__grow_mode::wrap::grab())
-            {
-                if (fputs("MATCHABLE(generated_matchable", f) == EOF)
-                    goto save_io_error;
-            }
-            else if (mode == save__grow_mode::always::grab())
-            {
-                if (fputs("GROW_MATCHABLE(generated_matchable", f) == EOF)
-                    goto save_io_error;
-            }
-            else
-            {
-                ret = save__status::no_grow_mode::grab();
-                goto save_cleanup;
-            }
-            int matchable_count{0};
-            for (auto const & [name, m] : matchables)
-            {
-                ++matchable_count;
-                if (matchable_count % 17 == 0)
-                {
-                    if (fputs(")\nGROW_MATCHABLE(", f) == EOF)
-                        goto save_io_error;
-
-                    if (fputs(name.c_str(), f) == EOF)
-                        goto save_io_error;
-                }
-                if (fputs(", ", f) == EOF)
-                    goto save_io_error;
+            print_generated_matchable(mode, out);
 
-                if (fputs(name.c_str(), f) == EOF)
-                    goto save_io_error;
-            }
-            if (fputs(")\n", f) == EOF)
-                goto save_io_error;
-        }
+        std::vector<std::string> pieces;
 
         if (content.is_set(save__content::matchables::grab()))
         {
-            // table recording whether each matchable has been written/saved (processed)
-            std::map<std::string, bool> processed;
-            for (auto const & [name, m] : matchables)
-                processed.insert({name, false});
+            // matchables in the order they are defined (or grown)
+            std::vector<Matchable const *> printed;
 
             // if just growing then the order does not matter,
             // so just go through them all and grow grow grow
             if (mode == save__grow_mode::always::grab())
             {
+                printed.reserve(matchables.size());
                 for (auto const & [name, m] : matchables)
-                {
-                    std::string printed_matchable = print_matchable(*m, mode);
-                    assert(printed_matchable.size());
-                    processed[name] = true;
-                    if (fputs(printed_matchable.c_str(), f) == EOF)
-                        goto save_io_error;
-                }
+                    printed.push_back(m);
             }
             // not always growing means we provide definitions
             // initial definitions must be resolved so that dependency definitions occur first
@@ -320,949 +715,2253 @@ namespace matchable
             {
                 // first forward declare all matchables resolving any dependency to self
                 for (auto const & [name, m] : matchables)
-                    if (fputs(print_matchable_fwd(*m).c_str(), f) == EOF)
-                        goto save_io_error;
+                    print_matchable_fwd(*m, out);
 
-                // for each iteration of the following while(), processed_count must be incremented...
-                // unchanged processed_count at end of iteration means we have cyclic dependencies!
-                int processed_count{0};
-                while (processed_count < (int) processed.size())
-                {
-                    int const prev_processed_count{processed_count};
+                if (!order_by_dependencies(printed))
+                    ret = save__status::cyclic_dependencies::grab();
+            } // not always growing
 
-                    for (auto const & [name, m] : matchables)
+            // initialize properties (in name order) of everything printed
+            std::unordered_set<Matchable const *> const defined(printed.begin(), printed.end());
+            std::vector<Matchable const *> initialized;
+            initialized.reserve(printed.size());
+            // tables carry their own properties
+            if (mode != save__grow_mode::table::grab())
+                for (auto const & [name, m] : matchables)
+                    if (defined.count(m) > 0)
+                        initialized.push_back(m);
+
+            // pieces depend on a single matchable each, so print them concurrently and write them in order
+            pieces.resize(printed.size() + initialized.size());
+            for_each_index_in_parallel(
+                pieces.size(),
+                [&](size_t i)
+                {
+                    if (i < printed.size())
                     {
-                        if (processed[name])
-                            continue;
-
-                        // ready means all dependencies to other matchables within this maker have already
-                        // been printed.
-                        bool ready{true};
-                        for (auto const & [s_type, s_name] : m->property_types_and_names)
-                        {
-                            static std::string const matchable_type_ending{"::Type"};
-                            if (s_type.size() > matchable_type_ending.size())
-                            {
-                                // get the matchable's 'namespace' name (if it is indeed a matchable at all)
-                                std::string const s_type_without_ending{
-                                    s_type.substr(0, s_type.size() - matchable_type_ending.size())
-                                };
-
-                                // if not self dependency (would be ok since we forward declared earlier) &&
-                                // if this matchable dependency is also one of those to be saved &&
-                                // if this matchable dependency has yet to be written then
-                                //     we still have unprocessed dependencies
-                                //     we must wait (stop looking at properties and skip to next matchable)
-                                if (
-                                    s_type_without_ending != name &&
-                                    processed.find(s_type_without_ending) != processed.end() &&
-                                    !processed[s_name]
-                                )
-                                {
-                                    ready = false;
-                                    break;
-                                }
-                            }
-                        }
-                        if (!ready) // dependencies exist that have yet to be written, skip and try later
-                            continue;
-
-                        // we are ready so write the matchable and record that we did so...
-                        std::string const printed_matchable{print_matchable(*m, mode)};
-                        if (fputs(printed_matchable.c_str(), f) == EOF)
-                            goto save_io_error;
-
-                        processed[name] = true;
-                        processed_count++;
+                        pieces[i].reserve(print_size(*printed[i]));
+                        print_matchable(*printed[i], mode, pieces[i]);
                     }
-
-                    // if we went through all the matchables and none of them were ready
-                    if (prev_processed_count == processed_count)
+                    else
                     {
-                        ret = save__status::cyclic_dependencies::grab();
-                        std::cout << "WARNING! cyclic dependencies detected and omitted!" << std::endl;
-                        for (auto const & [name, p] : processed)
-                        {
-                            if (!p)
-                            {
-                                std::cout << "    " << name << " : ";
-                                for (auto const & [t, n] : matchables[name]->property_types_and_names)
-                                    std::cout << " " << n;
-                                std::cout << std::endl;
-                            }
-                        }
-                        break;
+                        Matchable const & m = *initialized[i - printed.size()];
+                        pieces[i].reserve(print_size(m));
+                        print_set_property(m, pieces[i]);
                     }
-                } // while matchables still need to be processed
-            } // not always growing
-
-            // initialize properties
-            for (auto const & [name, m] : matchables)
-                if (processed[name])
-                    if (fputs(print_set_property(*m).c_str(), f) == EOF)
-                        return save__status::io_error::grab();
+                }
+            );
         }
 
-        goto save_cleanup;
-
-save_io_error:
-        ret = save__status::io_error::grab();
+        std::vector<std::string_view> parts{out};
+        parts.insert(parts.end(), pieces.begin(), pieces.end());
+        if (!write_file(filename, parts))
+            return save__status::io_error::grab();
 
-save_cleanup:
-        fclose(f);
         return ret;
     }
 
 
-    MATCHABLE(
-        MatchableKeyword,
-        esc_MATCHABLE_FWD,
-        esc_MATCHABLE,
-        esc_PROPERTYx1_MATCHABLE,
-        esc_PROPERTYx2_MATCHABLE,
-        esc_PROPERTYx3_MATCHABLE,
-        esc_PROPERTYx4_MATCHABLE,
-        esc_PROPERTYx5_MATCHABLE,
-        esc_PROPERTYx6_MATCHABLE,
-        esc_PROPERTYx7_MATCHABLE,
-        esc_PROPERTYx8_MATCHABLE,
-        esc_PROPERTYx9_MATCHABLE,
-        esc_PROPERTYx10_MATCHABLE,
-        esc_PROPERTYx11_MATCHABLE,
-        esc_PROPERTYx12_MATCHABLE,
-        esc_PROPERTYx13_MATCHABLE,
-        esc_PROPERTYx14_MATCHABLE,
-        esc_PROPERTYx15_MATCHABLE,
-        esc_PROPERTYx16_MATCHABLE,
-        esc_PROPERTYx17_MATCHABLE,
-        esc_PROPERTYx18_MATCHABLE,
-        esc_PROPERTYx19_MATCHABLE,
-        esc_PROPERTYx20_MATCHABLE,
-        esc_PROPERTYx21_MATCHABLE,
-        esc_GROW_MATCHABLE,
-        esc_MATCHABLE_VARIANT_PROPERTY_VALUE,
-        esc_MATCHABLE_VARIANT_PROPERTY_VALUES
-    );
-
-
-    load__status::Type MatchableMaker::load(std::string const & filename)
+    save__status::Type MatchableMaker::save_sharded(
+        std::string const & header_filename,
+        int shard_count,
+        save__content::Flags const & content
+    )
     {
-        FILE * f = fopen(filename.c_str(), "r");
+        if (content.currently_set().size() == 0)
+            return save__status::no_content::grab();
 
-        if (nullptr == f)
-            return load__status::io_error::grab();
+        if (shard_count < 1)
+            shard_count = 1;
 
-        load__status::Type ret{load__status::success::grab()};
+        save__status::Type ret{save__status::success::grab()};
 
-        int ch;
-        std::string str;
-        MatchableKeyword::Type keyword;
-        std::vector<std::string> args;
-        int paren_balance{0};
+        // header: declarations only, so that including it stays cheap no matter how many variants exist
+        std::string header{
+            "#pragma once\n\n\n"
+            "#include <matchable/matchable.h>\n"
+            "#include <matchable/matchable_fwd.h>\n\n\n\n"
+        };
+        if (content.is_set(save__content::generated_matchable::grab()))
+            print_generated_matchable(save__grow_mode::wrap::grab(), header);
 
-        // loop over header file containing matchable keywords character by character
-        while (true)
+        std::vector<Matchable const *> ordered;
+        if (content.is_set(save__content::matchables::grab()))
         {
-            keyword = MatchableKeyword::nil;
-            args.clear();
+            for (auto const & [name, m] : matchables)
+                print_matchable_fwd(*m, header);
 
-            // read next valid keyword
-            while (keyword.is_nil())
-            {
-                str.clear();
+            if (!order_by_dependencies(ordered))
+                ret = save__status::cyclic_dependencies::grab();
 
-                while (true)
-                {
-                    ch = fgetc(f);
+            for (auto m : ordered)
+                print_matchable_declaration(*m, header);
+        }
 
-                    if (ch == EOF)
-                        goto load_end;
+        // Property values may refer to variants of the matchables they depend on, so matchables connected
+        // by dependencies share a shard. Groups are assigned largest first to the least loaded shard.
+        std::unordered_map<Matchable const *, size_t> group_of;
+        std::vector<size_t> parent(ordered.size());
+        for (size_t i = 0; i < ordered.size(); ++i)
+        {
+            group_of.insert({ordered[i], i});
+            parent[i] = i;
+        }
+        auto root =
+            [&parent](size_t i)
+            {
+                while (parent[i] != i)
+                    i = parent[i] = parent[parent[i]];
+                return i;
+            };
+        for (size_t i = 0; i < ordered.size(); ++i)
+        {
+            for (auto const & [p_type, p_name] : ordered[i]->property_types_and_names)
+            {
+                auto dependency = group_of.find(matchable_dependency(matchables, p_type));
+                if (dependency != group_of.end())
+                    parent[root(i)] = root(dependency->second);
+            }
+        }
+
+        std::map<size_t, std::vector<Matchable const *>> groups;
+        std::map<size_t, size_t> group_weights;
+        for (size_t i = 0; i < ordered.size(); ++i)
+        {
+            size_t const g = root(i);
+            groups[g].push_back(ordered[i]);
+            group_weights[g] += 1 + ordered[i]->variants.size();
+            for (auto const & v : ordered[i]->variants)
+                group_weights[g] += v.properties.size();
+        }
+        std::vector<size_t> groups_by_weight;
+        for (auto const & [g, w] : group_weights)
+            groups_by_weight.push_back(g);
+        std::stable_sort(
+            groups_by_weight.begin(),
+            groups_by_weight.end(),
+            [&](size_t a, size_t b) { return group_weights[a] > group_weights[b]; }
+        );
+
+        std::vector<std::vector<Matchable const *>> shards(shard_count);
+        std::vector<size_t> shard_weights(shard_count, 0);
+        for (auto g : groups_by_weight)
+        {
+            size_t const lightest = std::min_element(shard_weights.begin(), shard_weights.end())
+                                    - shard_weights.begin();
+            shards[lightest].insert(shards[lightest].end(), groups[g].begin(), groups[g].end());
+            shard_weights[lightest] += group_weights[g];
+        }
+
+        if (!write_file(header_filename, header))
+            return save__status::io_error::grab();
+
+        size_t const separator = header_filename.find_last_of("/\\");
+        std::string const header_include{
+            separator == std::string::npos ? header_filename : header_filename.substr(separator + 1)
+        };
+        // shards are independent of each other, so they are printed and written concurrently
+        std::atomic<bool> shards_written{true};
+        for_each_index_in_parallel(
+            shard_count,
+            [&](size_t i)
+            {
+                // keep dependency order within the shard, growing everything before setting any property
+                std::sort(
+                    shards[i].begin(),
+                    shards[i].end(),
+                    [&](auto a, auto b) { return group_of.at(a) < group_of.at(b); }
+                );
+
+                std::string shard{"#include \"" + header_include + "\"\n\n\n\n"};
+                size_t shard_size{shard.size()};
+                for (auto m : shards[i])
+                    shard_size += print_size(*m);
+                shard.reserve(shard_size);
+                for (auto m : shards[i])
+                    if (m->variants.size() > 0)
+                        print_matchable(*m, save__grow_mode::always::grab(), shard);
+                for (auto m : shards[i])
+                    print_set_property(*m, shard);
+
+                if (!write_file(shard_filename(header_filename, static_cast<int>(i)), shard))
+                    shards_written = false;
+            }
+        );
+        if (!shards_written)
+            return save__status::io_error::grab();
+
+        return ret;
+    }
+
+
+    std::string MatchableMaker::shard_filename(std::string const & header_filename, int shard)
+    {
+        size_t const separator = header_filename.find_last_of("/\\");
+        size_t dot = header_filename.rfind('.');
+        if (dot == std::string::npos || (separator != std::string::npos && dot < separator))
+            dot = header_filename.size();
+        return header_filename.substr(0, dot) + "_" + std::to_string(shard) + ".cpp";
+    }
+
+
+    namespace
+    {
+        // Read only view of an entire file, memory mapped where available
+        class FileView
+        {
+        public:
+            FileView() = default;
+            FileView(FileView const &) = delete;
+            FileView & operator=(FileView const &) = delete;
+            ~FileView();
+            bool open(std::string const & filename);
+            std::string_view view() const { return std::string_view(data, size); }
+
+        private:
+            char const * data{nullptr};
+            size_t size{0};
+#ifdef _WIN32
+            std::string contents;
+#else
+            void * mapping{nullptr};
+#endif
+        };
+
+
+        FileView::~FileView()
+        {
+#ifndef _WIN32
+            if (nullptr != mapping)
+                munmap(mapping, size);
+#endif
+        }
+
+
+        bool FileView::open(std::string const & filename)
+        {
+#ifdef _WIN32
+            FILE * f = fopen(filename.c_str(), "rb");
+            if (nullptr == f)
+                return false;
+
+            char buffer[65536];
+            size_t read_count{0};
+            while ((read_count = fread(buffer, 1, sizeof(buffer), f)) > 0)
+                contents.append(buffer, read_count);
+            bool const ok = ferror(f) == 0;
+            fclose(f);
+            data = contents.data();
+            size = contents.size();
+            return ok;
+#else
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                close(fd);
+                return false;
+            }
+
+            size = static_cast<size_t>(st.st_size);
+            if (size > 0)
+            {
+                mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    mapping = nullptr;
+                    size = 0;
+                    close(fd);
+                    return false;
+                }
+                data = static_cast<char const *>(mapping);
+            }
+            close(fd);
+            return true;
+#endif
+        }
+
+
+        std::string_view trim(std::string_view sv)
+        {
+            static char const * const whitespace{" \t\r\n"};
+            size_t const begin = sv.find_first_not_of(whitespace);
+            if (begin == std::string_view::npos)
+                return {};
+            return sv.substr(begin, sv.find_last_not_of(whitespace) - begin + 1);
+        }
+
+
+        // " at line L, column C" for the given offset (only computed when reporting errors)
+        std::string position_of(std::string_view text, size_t offset)
+        {
+            size_t const line = 1 + std::count(text.begin(), text.begin() + offset, '\n');
+            size_t const line_begin = text.rfind('\n', offset == 0 ? 0 : offset - 1);
+            size_t const column = line_begin == std::string_view::npos || offset == 0
+                    ? offset + 1
+                    : offset - line_begin;
+            return " at line " + std::to_string(line) + ", column " + std::to_string(column);
+        }
+    }
+
+
+    MATCHABLE(
+        MatchableKeyword,
+        esc_MATCHABLE_FWD,
+        esc_MATCHABLE,
+        esc_PROPERTYx1_MATCHABLE,
+        esc_PROPERTYx2_MATCHABLE,
+        esc_PROPERTYx3_MATCHABLE,
+        esc_PROPERTYx4_MATCHABLE,
+        esc_PROPERTYx5_MATCHABLE,
+        esc_PROPERTYx6_MATCHABLE,
+        esc_PROPERTYx7_MATCHABLE,
+        esc_PROPERTYx8_MATCHABLE,
+        esc_PROPERTYx9_MATCHABLE,
+        esc_PROPERTYx10_MATCHABLE,
+        esc_PROPERTYx11_MATCHABLE,
+        esc_PROPERTYx12_MATCHABLE,
+        esc_PROPERTYx13_MATCHABLE,
+        esc_PROPERTYx14_MATCHABLE,
+        esc_PROPERTYx15_MATCHABLE,
+        esc_PROPERTYx16_MATCHABLE,
+        esc_PROPERTYx17_MATCHABLE,
+        esc_PROPERTYx18_MATCHABLE,
+        esc_PROPERTYx19_MATCHABLE,
+        esc_PROPERTYx20_MATCHABLE,
+        esc_PROPERTYx21_MATCHABLE,
+        esc_GROW_MATCHABLE,
+        esc_MATCHABLE_VARIANT_PROPERTY_VALUE,
+        esc_MATCHABLE_VARIANT_PROPERTY_VALUES
+    );
+
+
+    load__status::Type MatchableMaker::load(std::string const & filename)
+    {
+        FileView file;
+        if (!file.open(filename))
+            return load__status::io_error::grab();
+
+        std::string_view const text = file.view();
+        load__status::Type ret{load__status::success::grab()};
+        MatchableKeyword::Type keyword;
+        size_t keyword_offset{0};
+        std::vector<std::string_view> args;
+
+        auto syntax_error =
+            [&](std::string const & expected)
+            {
+                std::cout << "Error loading " << keyword << "(), expected " << expected << " (got "
+                          << args.size() << ")" << position_of(text, keyword_offset) << std::endl;
+                ret = load__status::syntax_error::grab();
+            };
+
+        auto load_variants =
+            [&](size_t name_index)
+            {
+                auto m = grab(std::string(args[name_index]));
+                for (size_t i = name_index + 1; i < args.size(); ++i)
+                    m->add_variant(std::string(args[i]));
+                return m;
+            };
+
+        // PROPERTYxN_MATCHABLE(type0, name0, ..., typeN-1, nameN-1, matchable, variants...)
+        auto load_property_matchable =
+            [&]()
+            {
+                size_t const property_count = std::stoul(keyword.as_string().substr(9));
+                if (args.size() < 2 * property_count + 1)
+                    return syntax_error(">= " + std::to_string(2 * property_count + 1) + " args");
+
+                auto m = load_variants(2 * property_count);
+                for (size_t i = 0; i < property_count; ++i)
+                    m->add_property(std::string(args[2 * i]), std::string(args[2 * i + 1]));
+            };
+
+        MatchableKeyword::Type::MatchParam keyword_handlers{
+            {MatchableKeyword::esc_MATCHABLE_FWD::grab(),
+                [&](){
+                    if (args.size() != 1)
+                        return syntax_error("1 arg");
+                    grab(std::string(args[0]));
+                }},
+
+            {MatchableKeyword::esc_MATCHABLE::grab(),
+                [&](){
+                    if (args.size() < 1)
+                        return syntax_error(">= 1 arg");
+                    load_variants(0);
+                }},
+
+            {MatchableKeyword::esc_GROW_MATCHABLE::grab(),
+                [&](){
+                    if (args.size() < 1)
+                        return syntax_error(">= 1 arg");
+                    load_variants(0);
+                }},
+
+            {MatchableKeyword::esc_MATCHABLE_VARIANT_PROPERTY_VALUE::grab(),
+                [&](){
+                    if (args.size() != 4)
+                        return syntax_error("4 args");
+                    grab(std::string(args[0]))->set_property(
+                        std::string(args[1]),
+                        std::string(args[2]),
+                        std::string(args[3])
+                    );
+                }},
+
+            {MatchableKeyword::esc_MATCHABLE_VARIANT_PROPERTY_VALUES::grab(),
+                [&](){
+                    if (args.size() < 3)
+                        return syntax_error(">= 3 args");
+                    std::vector<std::string> property_values;
+                    property_values.reserve(args.size() - 3);
+                    for (size_t i = 3; i < args.size(); ++i)
+                        property_values.emplace_back(args[i]);
+                    grab(std::string(args[0]))->set_propertyvect(
+                        std::string(args[1]),
+                        std::string(args[2]),
+                        property_values
+                    );
+                }},
+        };
+        for (auto const & k : MatchableKeyword::variants())
+            if (k.as_string().substr(0, 9) == "PROPERTYx")
+                keyword_handlers.set(k, load_property_matchable);
+
+        static char const * const arg_delimiters{"(),\"'"};
+        size_t pos{0};
+        while (ret == load__status::success::grab())
+        {
+            // find next keyword, a keyword is all that precedes '(' on the same line
+            size_t const open_paren = text.find('(', pos);
+            if (open_paren == std::string_view::npos)
+                break;
+
+            size_t keyword_begin = text.find_last_of('\n', open_paren);
+            keyword_begin = keyword_begin == std::string_view::npos ? 0 : keyword_begin + 1;
+            keyword_begin = std::max(keyword_begin, pos);
+            std::string_view const keyword_view =
+                    trim(text.substr(keyword_begin, open_paren - keyword_begin));
+            pos = open_paren + 1;
+
+            keyword = MatchableKeyword::from_string(std::string(keyword_view));
+            if (keyword.is_nil())
+                continue;
+            keyword_offset = keyword_view.data() - text.data();
+
+            // split arguments at top level commas, skipping nested parentheses and quoted literals
+            args.clear();
+            size_t arg_begin{pos};
+            int depth{0};
+            bool closed{false};
+            for (size_t i = text.find_first_of(arg_delimiters, pos);
+                 i != std::string_view::npos;
+                 i = text.find_first_of(arg_delimiters, i + 1))
+            {
+                char const ch = text[i];
+                if (ch == '"' || ch == '\'')
+                {
+                    size_t close = i + 1;
+                    while (close < text.size() && text[close] != ch)
+                        close += text[close] == '\\' ? 2 : 1;
+                    if (close >= text.size())
+                        break;
+                    i = close;
+                }
+                else if (ch == '(')
+                {
+                    ++depth;
+                }
+                else if (ch == ')' && depth > 0)
+                {
+                    --depth;
+                }
+                else
+                {
+                    args.push_back(trim(text.substr(arg_begin, i - arg_begin)));
+                    arg_begin = i + 1;
+                    if (ch == ')')
+                    {
+                        closed = true;
+                        pos = i + 1;
+                        break;
+                    }
+                }
+            }
+
+            if (!closed)
+            {
+                std::cout << "Error loading " << keyword << "(), missing closing ')'"
+                          << position_of(text, keyword_offset) << std::endl;
+                ret = load__status::syntax_error::grab();
+                break;
+            }
+
+            // generated_matchable (save__content::generated_matchable) lists the matchables saved with it
+            // and is printed again when saving rather than being one of the maker's matchables
+            if (args.size() > 0 && args[0] == "generated_matchable" &&
+                    keyword.as_string().substr(0, 9) != "PROPERTYx")
+                continue;
+
+            keyword.match(keyword_handlers);
+        }
+
+        return ret;
+    }
+
+
+    namespace
+    {
+        // Splits delimited text into records one at a time, keeping only the current record in memory
+        class DelimitedReader
+        {
+        public:
+            DelimitedReader(std::istream & in, char delimiter, bool quoted)
+                : in{in}, delimiter{delimiter}, quoted{quoted}
+            {
+            }
+
+            // the next non-empty record, its fields remaining valid until the following call
+            bool next(std::vector<std::string_view> & fields);
+            size_t line() const { return line_number; }
+            bool unterminated_quote() const { return bad_quote; }
+
+        private:
+            bool read_line();
+
+            std::istream & in;
+            char const delimiter;
+            bool const quoted;
+            std::string buffer;
+            std::string record;
+            std::vector<std::pair<size_t, size_t>> spans;
+            size_t line_number{0};
+            bool bad_quote{false};
+        };
+
+
+        bool DelimitedReader::read_line()
+        {
+            if (!std::getline(in, buffer))
+                return false;
+
+            ++line_number;
+            if (!buffer.empty() && buffer.back() == '\r')
+                buffer.pop_back();
+            return true;
+        }
+
+
+        bool DelimitedReader::next(std::vector<std::string_view> & fields)
+        {
+            fields.clear();
+            do
+            {
+                if (!read_line())
+                    return false;
+            } while (buffer.empty());
+
+            if (!quoted)
+            {
+                size_t begin{0};
+                for (size_t end = buffer.find(delimiter);
+                     end != std::string::npos;
+                     end = buffer.find(delimiter, begin))
+                {
+                    fields.push_back(std::string_view{buffer}.substr(begin, end - begin));
+                    begin = end + 1;
+                }
+                fields.push_back(std::string_view{buffer}.substr(begin));
+                return true;
+            }
+
+            // fields are unquoted into record (copying runs between quotes and delimiters all at once),
+            // a quoted field may continue on the following lines
+            char const specials[2]{'"', delimiter};
+            record.clear();
+            spans.clear();
+            size_t field_begin{0};
+            bool in_quotes{false};
+            size_t i{0};
+            while (true)
+            {
+                if (in_quotes)
+                {
+                    size_t const quote = buffer.find('"', i);
+                    if (quote == std::string::npos)
+                    {
+                        record.append(buffer, i);
+                        record += '\n';
+                        if (!read_line())
+                        {
+                            bad_quote = true;
+                            return false;
+                        }
+                        i = 0;
+                        continue;
+                    }
+                    record.append(buffer, i, quote - i);
+                    i = quote + 1;
+                    if (i < buffer.size() && buffer[i] == '"')
+                    {
+                        record += '"';
+                        ++i;
+                    }
+                    else
+                    {
+                        in_quotes = false;
+                    }
+                    continue;
+                }
+
+                size_t const special = buffer.find_first_of(std::string_view{specials, 2}, i);
+                if (special == std::string::npos)
+                {
+                    record.append(buffer, i);
+                    break;
+                }
+                record.append(buffer, i, special - i);
+                i = special + 1;
+                if (buffer[special] == '"')
+                {
+                    in_quotes = true;
+                }
+                else
+                {
+                    spans.push_back({field_begin, record.size()});
+                    field_begin = record.size();
+                }
+            }
+            spans.push_back({field_begin, record.size()});
+
+            for (auto [begin, end] : spans)
+                fields.push_back(std::string_view{record}.substr(begin, end - begin));
+            return true;
+        }
+
+
+        // Members of a flat JSON object written on one line, values being strings, literals (numbers, true,
+        // false), null or arrays of strings and literals
+        class JsonLineParser
+        {
+        public:
+            struct Member
+            {
+                std::string_view key;
+                std::string_view value;
+                bool is_null{false};
+                bool is_array{false};
+                size_t elements_begin{0};
+                size_t elements_end{0};
+            };
+
+            // members remain valid until the next call, false (see error()) if line is not such an object
+            bool parse(std::string_view line);
+            std::vector<Member> const & members() const { return parsed; }
+            std::string_view element(size_t i) const { return elements[i]; }
+            std::string const & error() const { return message; }
+            size_t error_column() const { return pos + 1; }
+
+        private:
+            bool value(std::string_view & out, bool & is_null);
+            bool string(std::string_view & out);
+            bool hex4(uint32_t & code);
+            void append_utf8(uint32_t code);
+            void skip_whitespace();
+            bool consume(char c);
+            bool fail(std::string const & m);
+
+            std::string_view text;
+            size_t pos{0};
+            // decoded strings are never longer than their escaped form, so reserving the length of the line
+            // up front keeps views of decoded valid
+            std::string decoded;
+            std::vector<Member> parsed;
+            std::vector<std::string_view> elements;
+            std::string message;
+        };
+
+
+        bool JsonLineParser::parse(std::string_view line)
+        {
+            text = line;
+            pos = 0;
+            decoded.clear();
+            decoded.reserve(line.size());
+            parsed.clear();
+            elements.clear();
+
+            skip_whitespace();
+            if (!consume('{'))
+                return fail("expected '{'");
+            skip_whitespace();
+            if (!consume('}'))
+            {
+                while (true)
+                {
+                    Member member;
+                    skip_whitespace();
+                    if (!string(member.key))
+                        return false;
+                    skip_whitespace();
+                    if (!consume(':'))
+                        return fail("expected ':'");
+                    skip_whitespace();
+                    if (consume('['))
+                    {
+                        member.is_array = true;
+                        member.elements_begin = elements.size();
+                        skip_whitespace();
+                        while (!consume(']'))
+                        {
+                            std::string_view element;
+                            bool is_null{false};
+                            if (!value(element, is_null))
+                                return false;
+                            if (is_null)
+                                return fail("null within an array");
+                            elements.push_back(element);
+                            skip_whitespace();
+                            if (!consume(',') && (pos >= text.size() || text[pos] != ']'))
+                                return fail("expected ',' or ']'");
+                            skip_whitespace();
+                        }
+                        member.elements_end = elements.size();
+                    }
+                    else if (!value(member.value, member.is_null))
+                    {
+                        return false;
+                    }
+                    parsed.push_back(member);
+
+                    skip_whitespace();
+                    if (consume('}'))
+                        break;
+                    if (!consume(','))
+                        return fail("expected ',' or '}'");
+                }
+            }
+
+            skip_whitespace();
+            return pos == text.size() || fail("unexpected characters after '}'");
+        }
+
+
+        bool JsonLineParser::value(std::string_view & out, bool & is_null)
+        {
+            if (pos < text.size() && text[pos] == '"')
+                return string(out);
+            if (pos < text.size() && (text[pos] == '{' || text[pos] == '['))
+                return fail("nested objects and arrays are not supported");
+
+            size_t const end = std::min(text.find_first_of(",]} \t\r", pos), text.size());
+            if (end == pos)
+                return fail("expected a value");
+            out = text.substr(pos, end - pos);
+            is_null = out == "null";
+            pos = end;
+            return true;
+        }
+
+
+        bool JsonLineParser::string(std::string_view & out)
+        {
+            if (!consume('"'))
+                return fail("expected '\"'");
+
+            // without escapes the string is viewed in place
+            size_t special = text.find_first_of("\"\\", pos);
+            if (special != std::string_view::npos && text[special] == '"')
+            {
+                out = text.substr(pos, special - pos);
+                pos = special + 1;
+                return true;
+            }
+
+            size_t const decoded_begin = decoded.size();
+            while (true)
+            {
+                special = text.find_first_of("\"\\", pos);
+                if (special == std::string_view::npos)
+                    return fail("unterminated string");
+                decoded.append(text.substr(pos, special - pos));
+                pos = special + 1;
+                if (text[special] == '"')
+                    break;
+                if (pos == text.size())
+                    return fail("unterminated string");
+
+                char const escaped = text[pos++];
+                switch (escaped)
+                {
+                    case '"': case '\\': case '/': decoded += escaped; break;
+                    case 'b': decoded += '\b'; break;
+                    case 'f': decoded += '\f'; break;
+                    case 'n': decoded += '\n'; break;
+                    case 'r': decoded += '\r'; break;
+                    case 't': decoded += '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t code{0};
+                        if (!hex4(code))
+                            return fail("bad \\u escape");
+                        // surrogate pair
+                        uint32_t low{0};
+                        if (code >= 0xd800 && code < 0xdc00 && text.substr(pos, 2) == "\\u")
+                        {
+                            pos += 2;
+                            if (!hex4(low) || low < 0xdc00 || low >= 0xe000)
+                                return fail("bad \\u escape");
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                        }
+                        append_utf8(code);
+                        break;
+                    }
+                    default:
+                        return fail(std::string("bad escape '\\") + escaped + "'");
+                }
+            }
+            out = std::string_view{decoded}.substr(decoded_begin);
+            return true;
+        }
+
+
+        bool JsonLineParser::hex4(uint32_t & code)
+        {
+            if (pos + 4 > text.size())
+                return false;
+
+            code = 0;
+            for (size_t end = pos + 4; pos < end; ++pos)
+            {
+                char const c = text[pos];
+                code <<= 4;
+                if (c >= '0' && c <= '9')
+                    code |= c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    code |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    code |= c - 'A' + 10;
+                else
+                    return false;
+            }
+            return true;
+        }
+
+
+        void JsonLineParser::append_utf8(uint32_t code)
+        {
+            if (code < 0x80)
+            {
+                decoded += static_cast<char>(code);
+            }
+            else if (code < 0x800)
+            {
+                decoded += static_cast<char>(0xc0 | (code >> 6));
+                decoded += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            else if (code < 0x10000)
+            {
+                decoded += static_cast<char>(0xe0 | (code >> 12));
+                decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                decoded += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            else
+            {
+                decoded += static_cast<char>(0xf0 | (code >> 18));
+                decoded += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+                decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                decoded += static_cast<char>(0x80 | (code & 0x3f));
+            }
+        }
+
+
+        void JsonLineParser::skip_whitespace()
+        {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r'))
+                ++pos;
+        }
+
+
+        bool JsonLineParser::consume(char c)
+        {
+            if (pos >= text.size() || text[pos] != c)
+                return false;
+
+            ++pos;
+            return true;
+        }
+
+
+        bool JsonLineParser::fail(std::string const & m)
+        {
+            message = m;
+            return false;
+        }
+
+
+        // Escape variant name of matchable m into an identifier (out), prefixing it with esc_ where it would
+        // otherwise start with a digit, be a keyword, clash with the names the MATCHABLE macros define within
+        // namespace m (Type, Flags, MatchableType and I<m>) or be reserved (starting with _ followed by an
+        // uppercase letter, or holding __). as_string() drops the prefix again. False if name holds bytes
+        // without an escape code, such as control characters.
+        bool escape_identifier(std::string_view name, std::string_view m, std::string & out)
+        {
+            static std::unordered_set<std::string_view> const reserved{
+                "alignas", "alignof", "and", "and_eq", "asm", "atomic_cancel", "atomic_commit",
+                "atomic_noexcept", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+                "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval",
+                "constexpr", "constinit", "const_cast", "continue", "co_await", "co_return", "co_yield",
+                "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit",
+                "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long",
+                "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+                "or_eq", "private", "protected", "public", "reflexpr", "register", "reinterpret_cast",
+                "requires", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast",
+                "struct", "switch", "synchronized", "template", "this", "thread_local", "throw", "true",
+                "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+                "volatile", "wchar_t", "while", "xor", "xor_eq", "assert", "clone", "create", "grab", "std",
+                "Type", "Flags", "MatchableType"
+            };
+
+            out.clear();
+            escapable::escape_all(name, out);
+            for (unsigned char ch : out)
+                if (!std::isalnum(ch) && ch != '_')
+                    return false;
+
+            bool const interface_name = out.size() == m.size() + 1 && out[0] == 'I' && out.substr(1) == m;
+            bool const reserved_identifier =
+                    out.find("__") != std::string::npos ||
+                    (out.size() > 1 && out[0] == '_' && std::isupper(static_cast<unsigned char>(out[1])));
+            if (out.empty() || std::isdigit(static_cast<unsigned char>(out[0])) ||
+                    out.compare(0, 4, "esc_") == 0 || reserved.count(out) > 0 || interface_name ||
+                    reserved_identifier)
+                out.insert(0, "esc_");
+            return true;
+        }
+    }
+
+
+    load__status::Type MatchableMaker::import_variants(
+        std::string const & m,
+        std::string const & filename,
+        import__format::Type format
+    )
+    {
+        std::ifstream in{filename, std::ios::binary};
+        if (!in)
+            return load__status::io_error::grab();
+
+        return import_variants(m, in, format);
+    }
+
+
+    load__status::Type MatchableMaker::import_variants(
+        std::string const & m,
+        std::istream & in,
+        import__format::Type format
+    )
+    {
+        if (format.is_nil())
+            return load__status::no_import_format::grab();
+
+        Matchable * matchable = grab(m);
+        size_t line{0};
+        std::string escaped;
+
+        // values are written in place as records are read, so the matchable counts as modified from here on
+        // even if a later record fails
+        matchable->touch();
+
+        auto syntax_error =
+            [&](std::string const & message, size_t column = 0)
+            {
+                std::cout << "Error importing " << m << ", " << message << " at line " << line;
+                if (column > 0)
+                    std::cout << ", column " << column;
+                std::cout << std::endl;
+                return load__status::syntax_error::grab();
+            };
+
+        auto add_variant =
+            [&](std::string_view name, size_t & position)
+            {
+                if (!escape_identifier(name, matchable->name, escaped))
+                    return false;
+                position = matchable->add_or_find_variant(escaped);
+                return true;
+            };
+        auto bad_variant_name =
+            [&](std::string_view name)
+            {
+                return syntax_error("no escape code for a character of \"" + std::string(name) + "\"");
+            };
+
+        // values are written straight into the variant's property slots, property names having been
+        // resolved once per column (or member)
+        auto property_of =
+            [&](size_t position, size_t id) -> MatchableProperty &
+            {
+                auto & properties = matchable->variants[position].properties;
+                if (properties.size() <= id)
+                    properties.resize(id + 1);
+                return properties[id];
+            };
+
+        if (format == import__format::jsonl::grab())
+        {
+            JsonLineParser parser;
+            std::string buffer;
+            std::vector<int> member_ids;
+            while (std::getline(in, buffer))
+            {
+                ++line;
+                if (trim(buffer).empty())
+                    continue;
+                if (!parser.parse(buffer))
+                    return syntax_error(parser.error(), parser.error_column());
+
+                auto const & members = parser.members();
+                if (members.empty() || members[0].is_array || members[0].is_null || members[0].value.empty())
+                    return syntax_error("expected the variant name as first member");
+
+                // the whole record is checked before any of it is imported
+                member_ids.clear();
+                for (size_t i = 1; i < members.size(); ++i)
+                {
+                    int const id = matchable->property_id(members[i].key);
+                    if (id == -1)
+                        return syntax_error("unknown property \"" + std::string(members[i].key) + "\"");
+                    member_ids.push_back(id);
+                }
+
+                size_t position{0};
+                if (!add_variant(members[0].value, position))
+                    return bad_variant_name(members[0].value);
+                for (size_t i = 1; i < members.size(); ++i)
+                {
+                    auto const & member = members[i];
+                    int const id = member_ids[i - 1];
+                    if (member.is_array)
+                    {
+                        auto & values = property_of(position, id).values;
+                        values.clear();
+                        for (size_t e = member.elements_begin; e < member.elements_end; ++e)
+                            values.emplace_back(parser.element(e));
+                    }
+                    else if (!member.is_null && !member.value.empty())
+                    {
+                        property_of(position, id).value.assign(member.value);
+                    }
+                }
+            }
+        }
+        else
+        {
+            bool const csv = format == import__format::csv::grab();
+            DelimitedReader reader{in, csv ? ',' : '\t', csv};
+            std::vector<std::string_view> fields;
+            std::vector<size_t> column_ids;
+            bool header{true};
+            while (reader.next(fields))
+            {
+                line = reader.line();
+                if (header)
+                {
+                    header = false;
+                    for (size_t i = 1; i < fields.size(); ++i)
+                    {
+                        int const id = matchable->property_id(trim(fields[i]));
+                        if (id == -1)
+                            return syntax_error("unknown property \"" + std::string(trim(fields[i])) + "\"");
+                        column_ids.push_back(id);
+                    }
+                    continue;
+                }
+
+                if (fields.size() > column_ids.size() + 1)
+                    return syntax_error("more fields than columns");
+                if (fields[0].empty())
+                    return syntax_error("missing variant name");
+
+                size_t position{0};
+                if (!add_variant(fields[0], position))
+                    return bad_variant_name(fields[0]);
+                for (size_t i = 1; i < fields.size(); ++i)
+                    if (!fields[i].empty())
+                        property_of(position, column_ids[i - 1]).value.assign(fields[i]);
+            }
+            if (reader.unterminated_quote())
+            {
+                line = reader.line();
+                return syntax_error("unterminated quote");
+            }
+        }
+
+        if (in.bad())
+            return load__status::io_error::grab();
+
+        return load__status::success::grab();
+    }
+
+
+    namespace
+    {
+        // Snapshot layout, all integers are native endian uint32_t:
+        //
+        //     "MTCHSNAP" version byte_order_mark
+        //     string_count string_bytes offsets[string_count + 1] bytes[string_bytes] (padded to 4 bytes)
+        //     matchable_count
+        //     for each matchable:
+        //         name property_count variant_count (type name)[property_count] variants[variant_count]
+        //         for each property column:
+        //             values[variant_count]
+        //             vect_offsets[variant_count + 1]
+        //             vect_values[vect_offsets[variant_count]]
+        //
+        // Names and values are string table indexes. A value of snapshot_unset means the property is not set
+        // for the variant.
+        constexpr char snapshot_magic[8]{'M', 'T', 'C', 'H', 'S', 'N', 'A', 'P'};
+        constexpr uint32_t snapshot_version{1};
+        constexpr uint32_t snapshot_byte_order_mark{0x01020304};
+        constexpr uint32_t snapshot_unset{0xffffffff};
+
+
+        class SnapshotWriter
+        {
+        public:
+            explicit SnapshotWriter(size_t expected_string_count)
+            {
+                strings.reserve(expected_string_count);
+            }
+
+            // s must outlive the writer
+            uint32_t intern(std::string_view s)
+            {
+                auto [it, inserted] = string_ids.try_emplace(s, static_cast<uint32_t>(strings.size()));
+                if (inserted)
+                    strings.push_back(s);
+                return it->second;
+            }
+
+            // like intern() for strings known to be unique, such as the variant names of a matchable
+            uint32_t add(std::string_view s)
+            {
+                strings.push_back(s);
+                return static_cast<uint32_t>(strings.size() - 1);
+            }
+
+            void put(uint32_t word) { words.push_back(word); }
+
+            // false if the string table does not fit the format
+            bool finish(std::string & out) const
+            {
+                size_t string_bytes{0};
+                for (auto s : strings)
+                    string_bytes += s.size();
+                if (string_bytes >= snapshot_unset || strings.size() >= snapshot_unset)
+                    return false;
+
+                size_t const padding = (4 - string_bytes % 4) % 4;
+                out.clear();
+                out.reserve(sizeof(snapshot_magic) + 4 * (4 + strings.size() + 1 + words.size())
+                        + string_bytes + padding);
+                out.append(snapshot_magic, sizeof(snapshot_magic));
+                append(out, snapshot_version);
+                append(out, snapshot_byte_order_mark);
+                append(out, static_cast<uint32_t>(strings.size()));
+                append(out, static_cast<uint32_t>(string_bytes));
+                uint32_t offset{0};
+                append(out, offset);
+                for (auto s : strings)
+                {
+                    offset += static_cast<uint32_t>(s.size());
+                    append(out, offset);
+                }
+                for (auto s : strings)
+                    out += s;
+                out.append(padding, '\0');
+                out.append(reinterpret_cast<char const *>(words.data()), 4 * words.size());
+                return true;
+            }
+
+        private:
+            static void append(std::string & out, uint32_t word)
+            {
+                out.append(reinterpret_cast<char const *>(&word), sizeof(word));
+            }
+
+            std::unordered_map<std::string_view, uint32_t> string_ids;
+            std::vector<std::string_view> strings;
+            std::vector<uint32_t> words;
+        };
+
+
+        // Bounds checked reads from a snapshot, once a read fails every later read fails as well
+        class SnapshotReader
+        {
+        public:
+            explicit SnapshotReader(std::string_view data) : data{data} {}
+
+            bool ok() const { return !failed; }
+            bool at_end() const { return pos == data.size(); }
+
+            bool skip(size_t bytes)
+            {
+                if (failed || data.size() - pos < bytes)
+                    return !(failed = true);
+                pos += bytes;
+                return true;
+            }
+
+            std::string_view bytes(size_t count)
+            {
+                size_t const begin = pos;
+                return skip(count) ? data.substr(begin, count) : std::string_view{};
+            }
+
+            uint32_t word()
+            {
+                uint32_t ret{0};
+                std::string_view const w = bytes(sizeof(ret));
+                if (!w.empty())
+                    std::memcpy(&ret, w.data(), sizeof(ret));
+                return ret;
+            }
+
+            // the next count words, read in place
+            std::string_view words(size_t count)
+            {
+                if (count > data.size())
+                    count = data.size() + 1;
+                return bytes(4 * count);
+            }
+
+            static uint32_t word_at(std::string_view words, size_t i)
+            {
+                uint32_t ret;
+                std::memcpy(&ret, words.data() + 4 * i, sizeof(ret));
+                return ret;
+            }
+
+        private:
+            std::string_view data;
+            size_t pos{0};
+            bool failed{false};
+        };
+    }
+
+
+    save__status::Type MatchableMaker::save_snapshot(std::string const & filename)
+    {
+        size_t variant_count{0};
+        for (auto const & [name, m] : matchables)
+            variant_count += m->variants.size();
+
+        SnapshotWriter writer{variant_count};
+        writer.put(static_cast<uint32_t>(matchables.size()));
+        for (auto const & [name, m] : matchables)
+        {
+            writer.put(writer.intern(m->name));
+            writer.put(static_cast<uint32_t>(m->property_types_and_names.size()));
+            writer.put(static_cast<uint32_t>(m->variants.size()));
+            for (auto const & [type, property_name] : m->property_types_and_names)
+            {
+                writer.put(writer.intern(type));
+                writer.put(writer.intern(property_name));
+            }
+            for (auto const & v : m->variants)
+                writer.put(writer.add(v.variant_name));
+
+            std::vector<uint32_t> vect_values;
+            std::vector<uint32_t> vect_offsets;
+            for (size_t p = 0; p < m->property_types_and_names.size(); ++p)
+            {
+                vect_values.clear();
+                vect_offsets.assign(1, 0);
+                for (auto const & v : m->variants)
+                {
+                    if (p >= v.properties.size() || !v.properties[p].is_set())
+                    {
+                        writer.put(snapshot_unset);
+                    }
+                    else
+                    {
+                        writer.put(writer.intern(v.properties[p].value));
+                        for (auto const & value : v.properties[p].values)
+                            vect_values.push_back(writer.intern(value));
+                    }
+                    vect_offsets.push_back(static_cast<uint32_t>(vect_values.size()));
+                }
+                for (auto offset : vect_offsets)
+                    writer.put(offset);
+                for (auto value : vect_values)
+                    writer.put(value);
+            }
+        }
+
+        std::string contents;
+        if (!writer.finish(contents) || !write_file(filename, contents))
+            return save__status::io_error::grab();
+
+        return save__status::success::grab();
+    }
+
+
+    load__status::Type MatchableMaker::load_snapshot(std::string const & filename)
+    {
+        FileView file;
+        if (!file.open(filename))
+            return load__status::io_error::grab();
+
+        SnapshotReader reader{file.view()};
+        std::string_view const magic{snapshot_magic, sizeof(snapshot_magic)};
+        if (reader.bytes(magic.size()) != magic)
+            return load__status::bad_snapshot::grab();
+        uint32_t const version = reader.word();
+        uint32_t const byte_order_mark = reader.word();
+        if (!reader.ok())
+            return load__status::bad_snapshot::grab();
+        if (version != snapshot_version || byte_order_mark != snapshot_byte_order_mark)
+            return load__status::unsupported_version::grab();
+
+        // string table
+        uint32_t const string_count = reader.word();
+        uint32_t const string_bytes = reader.word();
+        std::string_view const offsets = reader.words(string_count + size_t{1});
+        std::string_view const string_data = reader.bytes(string_bytes);
+        reader.skip((4 - string_bytes % 4) % 4);
+        if (!reader.ok())
+            return load__status::bad_snapshot::grab();
+
+        std::vector<std::string_view> strings;
+        strings.reserve(string_count);
+        for (uint32_t i = 0; i < string_count; ++i)
+        {
+            uint32_t const begin = SnapshotReader::word_at(offsets, i);
+            uint32_t const end = SnapshotReader::word_at(offsets, i + 1);
+            if (begin > end || end > string_bytes)
+                return load__status::bad_snapshot::grab();
+            strings.push_back(string_data.substr(begin, end - begin));
+        }
+
+        bool bad_index{false};
+        auto string_at =
+            [&](uint32_t index)
+            {
+                if (index >= strings.size())
+                {
+                    bad_index = true;
+                    return std::string_view{};
+                }
+                return strings[index];
+            };
+
+        // matchables are read in full before any of them replaces a matchable of the same name, so that a
+        // bad snapshot leaves the maker as it was. Variants are read into the maker's pool, from which the
+        // matchables replaced then take them over without copying
+        struct LoadedMatchable
+        {
+            std::string name;
+            std::vector<std::pair<std::string, std::string>> property_types_and_names;
+            std::pmr::vector<MatchableVariant> variants;
+        };
+        uint32_t const matchable_count = reader.word();
+        std::vector<LoadedMatchable> loaded;
+        loaded.reserve(std::min<size_t>(matchable_count, file.view().size() / 12));
+        for (uint32_t i = 0; i < matchable_count && reader.ok() && !bad_index; ++i)
+        {
+            uint32_t const name = reader.word();
+            uint32_t const property_count = reader.word();
+            uint32_t const variant_count = reader.word();
+            std::string_view const properties = reader.words(2 * size_t{property_count});
+            std::string_view const variant_names = reader.words(variant_count);
+            if (!reader.ok())
+                break;
+
+            LoadedMatchable & m = loaded.emplace_back(
+                LoadedMatchable{{}, {}, std::pmr::vector<MatchableVariant>{pool.node_resource()}}
+            );
+            m.name = string_at(name);
+            if (m.name.empty())
+                bad_index = true;
+            m.property_types_and_names.reserve(property_count);
+            for (uint32_t p = 0; p < property_count; ++p)
+                m.property_types_and_names.emplace_back(
+                    string_at(SnapshotReader::word_at(properties, 2 * p)),
+                    string_at(SnapshotReader::word_at(properties, 2 * p + 1))
+                );
+            m.variants.resize(variant_count);
+            for (uint32_t v = 0; v < variant_count; ++v)
+                m.variants[v].variant_name = string_at(SnapshotReader::word_at(variant_names, v));
+
+            for (uint32_t p = 0; p < property_count && reader.ok() && !bad_index; ++p)
+            {
+                std::string_view const values = reader.words(variant_count);
+                std::string_view const vect_offsets = reader.words(variant_count + size_t{1});
+                if (!reader.ok())
+                    break;
+                uint32_t const vect_count = SnapshotReader::word_at(vect_offsets, variant_count);
+                std::string_view const vect_values = reader.words(vect_count);
+                if (!reader.ok())
+                    break;
+
+                for (uint32_t v = 0; v < variant_count; ++v)
+                {
+                    uint32_t const value = SnapshotReader::word_at(values, v);
+                    uint32_t const vect_begin = SnapshotReader::word_at(vect_offsets, v);
+                    uint32_t const vect_end = SnapshotReader::word_at(vect_offsets, v + 1);
+                    if (vect_begin > vect_end || vect_end > vect_count)
+                    {
+                        bad_index = true;
+                        break;
+                    }
+                    if (value == snapshot_unset)
+                        continue;
+
+                    auto & properties = m.variants[v].properties;
+                    if (properties.size() <= p)
+                        properties.resize(p + 1);
+                    properties[p].value = string_at(value);
+                    auto & property_values = properties[p].values;
+                    property_values.reserve(vect_end - vect_begin);
+                    for (uint32_t e = vect_begin; e < vect_end; ++e)
+                        property_values.emplace_back(string_at(SnapshotReader::word_at(vect_values, e)));
+                }
+            }
+        }
+
+        if (!reader.ok() || bad_index || !reader.at_end() || loaded.size() != matchable_count)
+            return load__status::bad_snapshot::grab();
+
+        // matchables already grabbed are replaced in place, so pointers to them stay valid
+        for (auto & m : loaded)
+            grab(m.name)->replace(std::move(m.property_types_and_names), std::move(m.variants));
+
+        return load__status::success::grab();
+    }
+
+
+    namespace
+    {
+        MatchableProperty const & property_of(MatchableVariant const & variant, int id)
+        {
+            static MatchableProperty const unset;
+            if (id < 0 || static_cast<size_t>(id) >= variant.properties.size())
+                return unset;
+            return variant.properties[id];
+        }
+
+
+        template<typename T>
+        diff__kind::Type kind_of_change(T const & before, T const & after)
+        {
+            if (before == T{})
+                return diff__kind::added::grab();
+            if (after == T{})
+                return diff__kind::removed::grab();
+            return diff__kind::changed::grab();
+        }
+    }
+
+
+    MATCHABLE(MergeResolution, keep, take, conflict);
+
+
+    // the outcome of a three-way merge of a single value, T{} standing for an absent value
+    template<typename T>
+    static MergeResolution::Type resolve(T const & base, T const & mine, T const & theirs)
+    {
+        if (theirs == base || theirs == mine)
+            return MergeResolution::keep::grab();
+        if (mine == base)
+            return MergeResolution::take::grab();
+        return MergeResolution::conflict::grab();
+    }
+
+
+    std::vector<MatchableChange> MatchableMaker::diff(MatchableMaker & other)
+    {
+        std::vector<MatchableChange> changes;
+
+        // both maps are ordered by name, so they are walked together
+        auto mine = matchables.begin();
+        auto theirs = other.matchables.begin();
+        while (mine != matchables.end() || theirs != other.matchables.end())
+        {
+            if (theirs == other.matchables.end() || (mine != matchables.end() && mine->first < theirs->first))
+            {
+                diff_matchables(mine->second, nullptr, mine->first, changes);
+                ++mine;
+            }
+            else if (mine == matchables.end() || theirs->first < mine->first)
+            {
+                diff_matchables(nullptr, theirs->second, theirs->first, changes);
+                ++theirs;
+            }
+            else
+            {
+                diff_matchables(mine->second, theirs->second, mine->first, changes);
+                ++mine;
+                ++theirs;
+            }
+        }
 
-                    if (ch == '(' || ch == 10 || ch == 13)
-                        break;
+        return changes;
+    }
 
-                    if (ch == ' ')
-                        continue;
 
-                    str += (char) ch;
-                }
+    void MatchableMaker::diff_matchables(
+        Matchable * before,
+        Matchable * after,
+        std::string const & name,
+        std::vector<MatchableChange> & changes
+    )
+    {
+        if (nullptr == before || nullptr == after)
+        {
+            changes.push_back({kind_of_change(before, after), name, {}, {}});
+            return;
+        }
+
+        // property declarations, paired by name
+        struct Column
+        {
+            std::string const * name;
+            int before;
+            int after;
+        };
+        std::vector<Column> columns;
+        for (size_t b = 0; b < before->property_types_and_names.size(); ++b)
+        {
+            auto const & [type, property] = before->property_types_and_names[b];
+            int const a = after->property_id(property);
+            if (a == -1)
+                changes.push_back({diff__kind::removed::grab(), name, {}, property});
+            else if (after->property_types_and_names[a].first != type)
+                changes.push_back({diff__kind::changed::grab(), name, {}, property});
+            columns.push_back({&property, static_cast<int>(b), a});
+        }
+        for (size_t a = 0; a < after->property_types_and_names.size(); ++a)
+        {
+            auto const & property = after->property_types_and_names[a].second;
+            if (before->property_id(property) != -1)
+                continue;
+            changes.push_back({diff__kind::added::grab(), name, {}, property});
+            columns.push_back({&property, -1, static_cast<int>(a)});
+        }
+
+        // variants of before in order, followed by those only found in after
+        size_t matched{0};
+        for (size_t i = 0; i < before->variants.size(); ++i)
+        {
+            auto const & variant = before->variants[i];
+            int const position = after->variant_position(variant.variant_name, i);
+            if (position == -1)
+            {
+                changes.push_back({diff__kind::removed::grab(), name, std::string(variant.variant_name), {}});
+                continue;
+            }
+            ++matched;
 
-                if (ch == '(')
-                    keyword = MatchableKeyword::from_string(str);
+            for (auto const & column : columns)
+            {
+                auto const & b = property_of(variant, column.before);
+                auto const & a = property_of(after->variants[position], column.after);
+                if (a != b)
+                    changes.push_back(
+                        {kind_of_change(b, a), name, std::string(variant.variant_name), *column.name}
+                    );
             }
+        }
+        if (matched < after->variants.size())
+            for (size_t i = 0; i < after->variants.size(); ++i)
+                if (before->variant_position(after->variants[i].variant_name, i) == -1)
+                {
+                    std::string variant_name{after->variants[i].variant_name};
+                    changes.push_back({diff__kind::added::grab(), name, std::move(variant_name), {}});
+                }
+    }
 
-            paren_balance = 0;
 
-            // read keyword's arguments (populate "args")
-            while (true)
+    std::vector<MatchableChange> MatchableMaker::merge(MatchableMaker & base, MatchableMaker & other)
+    {
+        std::vector<MatchableChange> conflicts;
+        std::vector<MatchableChange> changes;
+        auto changed_since_base =
+            [&](Matchable * base_m, Matchable * m)
             {
-                str.clear();
+                changes.clear();
+                diff_matchables(base_m, m, base_m->name, changes);
+                return !changes.empty();
+            };
 
-                while (true)
-                {
-                    ch = fgetc(f);
+        for (auto const & [name, theirs] : other.matchables)
+        {
+            auto const base_it = base.matchables.find(name);
+            Matchable * base_m = base_it == base.matchables.end() ? nullptr : base_it->second;
+            auto const mine = matchables.find(name);
+            if (mine != matchables.end())
+                merge_matchables(*mine->second, base_m, *theirs, conflicts);
+            else if (nullptr == base_m)
+                merge_matchables(*grab(name), nullptr, *theirs, conflicts);
+            else if (changed_since_base(base_m, theirs))
+                conflicts.push_back({diff__kind::changed::grab(), name, {}, {}});
+        }
 
-                    if (ch == EOF)
-                        goto load_end;
+        // matchables removed by other are removed here as well unless changed here
+        for (auto const & [name, base_m] : base.matchables)
+        {
+            if (other.matchables.count(name) > 0)
+                continue;
+            auto const mine = matchables.find(name);
+            if (mine == matchables.end())
+                continue;
 
-                    if (ch == '(')
-                        --paren_balance;
+            if (changed_since_base(base_m, mine->second))
+            {
+                conflicts.push_back({diff__kind::removed::grab(), name, {}, {}});
+            }
+            else
+            {
+                destroy_matchable(mine->second);
+                matchables.erase(mine);
+            }
+        }
 
-                    if (ch == ',' || (ch == ')' && paren_balance == 0))
-                        break;
+        return conflicts;
+    }
 
-                    if (ch == ')')
-                        ++paren_balance;
 
-                    if (ch == ' ')
-                        continue;
+    void MatchableMaker::merge_matchables(
+        Matchable & mine,
+        Matchable * base,
+        Matchable & theirs,
+        std::vector<MatchableChange> & conflicts
+    )
+    {
+        std::string const & name = mine.name;
+        bool modified{false};
+        std::string const no_type;
+        auto base_type =
+            [&](std::string const & property) -> std::string const &
+            {
+                int const id = nullptr == base ? -1 : base->property_id(property);
+                return id == -1 ? no_type : base->property_types_and_names[id].first;
+            };
+
+        // property declarations added or changed by theirs
+        for (auto const & [type, property] : theirs.property_types_and_names)
+        {
+            int const m = mine.property_id(property);
+            std::string const & mine_type = m == -1 ? no_type : mine.property_types_and_names[m].first;
+            std::string const & b_type = base_type(property);
+            auto const resolution = resolve(b_type, mine_type, type);
+            if (resolution == MergeResolution::take::grab())
+            {
+                modified = true;
+                if (m == -1)
+                    mine.add_property(type, property);
+                else
+                    mine.property_types_and_names[m].first = type;
+            }
+            else if (resolution == MergeResolution::conflict::grab())
+            {
+                conflicts.push_back({kind_of_change(b_type, type), name, {}, property});
+            }
+        }
+
+        // ids within each matchable of every property declared by any of them (-1 where not declared)
+        struct Column
+        {
+            std::string const * name;
+            int base;
+            int mine;
+            int theirs;
+            bool conflicted;
+        };
+        std::vector<Column> columns;
+        auto add_column =
+            [&](std::string const & property)
+            {
+                columns.push_back(
+                    {
+                        &property,
+                        nullptr == base ? -1 : base->property_id(property),
+                        mine.property_id(property),
+                        theirs.property_id(property),
+                        false
+                    }
+                );
+            };
+        for (auto const & [type, property] : mine.property_types_and_names)
+            add_column(property);
+        for (auto const & [type, property] : theirs.property_types_and_names)
+            if (mine.property_id(property) == -1)
+                add_column(property);
+        if (nullptr != base)
+            for (auto const & [type, property] : base->property_types_and_names)
+                if (mine.property_id(property) == -1 && theirs.property_id(property) == -1)
+                    add_column(property);
+
+        // whether variants a and b have different property values (ids of a and b selected by a_id and b_id)
+        auto differs =
+            [&](
+                MatchableVariant const & a,
+                int Column::* a_id,
+                MatchableVariant const & b,
+                int Column::* b_id
+            )
+            {
+                for (auto const & column : columns)
+                    if (property_of(a, column.*a_id) != property_of(b, column.*b_id))
+                        return true;
+                return false;
+            };
 
-                    str += (char) ch;
+        // variants added or changed by theirs
+        MatchableVariant const no_variant;
+        for (size_t i = 0; i < theirs.variants.size(); ++i)
+        {
+            auto const & their_variant = theirs.variants[i];
+            std::string const variant_name{their_variant.variant_name};
+            int const base_position = nullptr == base ? -1 : base->variant_position(variant_name, i);
+            MatchableVariant const & base_variant =
+                    base_position == -1 ? no_variant : base->variants[base_position];
+            int position = mine.variant_position(variant_name, i);
+            if (position == -1)
+            {
+                // removed here
+                if (base_position != -1)
+                {
+                    if (differs(base_variant, &Column::base, their_variant, &Column::theirs))
+                        conflicts.push_back({diff__kind::changed::grab(), name, variant_name, {}});
+                    continue;
                 }
+                position = mine.add_or_find_variant(variant_name);
+                modified = true;
+            }
 
-                args.push_back(str);
+            for (auto & column : columns)
+            {
+                auto const & b = property_of(base_variant, column.base);
+                auto const & t = property_of(their_variant, column.theirs);
+                auto const & m = property_of(mine.variants[position], column.mine);
+                auto const resolution = resolve(b, m, t);
+                if (resolution == MergeResolution::take::grab() && column.mine != -1)
+                {
+                    auto & properties = mine.variants[position].properties;
+                    if (properties.size() <= static_cast<size_t>(column.mine))
+                        properties.resize(column.mine + 1);
+                    properties[column.mine] = t;
+                    modified = true;
+                }
+                else if (resolution != MergeResolution::keep::grab())
+                {
+                    conflicts.push_back({kind_of_change(b, t), name, variant_name, *column.name});
+                    column.conflicted = true;
+                }
+            }
+        }
 
-                if (ch == ')')
-                    break;
+        // variants removed by theirs, removed here all at once unless changed here
+        if (nullptr != base)
+        {
+            std::vector<bool> removed(mine.variants.size(), false);
+            bool any_removed{false};
+            for (size_t i = 0; i < base->variants.size(); ++i)
+            {
+                auto const & base_variant = base->variants[i];
+                if (theirs.variant_position(base_variant.variant_name, i) != -1)
+                    continue;
+                int const position = mine.variant_position(base_variant.variant_name, i);
+                if (position == -1)
+                    continue;
+
+                if (differs(base_variant, &Column::base, mine.variants[position], &Column::mine))
+                {
+                    conflicts.push_back(
+                        {diff__kind::removed::grab(), name, std::string(base_variant.variant_name), {}}
+                    );
+                }
+                else
+                {
+                    removed[position] = true;
+                    any_removed = true;
+                }
+            }
+            if (any_removed)
+            {
+                size_t kept{0};
+                for (size_t i = 0; i < mine.variants.size(); ++i)
+                {
+                    if (removed[i])
+                        continue;
+                    if (kept != i)
+                        mine.variants[kept] = std::move(mine.variants[i]);
+                    ++kept;
+                }
+                mine.variants.resize(kept);
+                mine.rebuild_variant_indexes();
+                modified = true;
             }
+        }
 
+        // property declarations removed by theirs, along with their values
+        if (nullptr != base)
+        {
+            std::vector<int> removed_ids;
+            for (auto const & column : columns)
+            {
+                if (column.base == -1 || column.theirs != -1 || column.mine == -1)
+                    continue;
+                auto const & b_type = base->property_types_and_names[column.base].first;
+                auto const & mine_type = mine.property_types_and_names[column.mine].first;
+                if (mine_type == b_type && !column.conflicted)
+                    removed_ids.push_back(column.mine);
+                else
+                    conflicts.push_back({diff__kind::removed::grab(), name, {}, *column.name});
+            }
+            std::sort(removed_ids.rbegin(), removed_ids.rend());
+            for (int id : removed_ids)
+            {
+                for (auto & variant : mine.variants)
+                    if (static_cast<size_t>(id) < variant.properties.size())
+                        variant.properties.erase(variant.properties.begin() + id);
+                mine.property_types_and_names.erase(mine.property_types_and_names.begin() + id);
+                modified = true;
+            }
+        }
 
-            // perform loading...
+        if (modified)
+            mine.touch();
+    }
 
-            keyword.match({
-                {MatchableKeyword::esc_MATCHABLE_FWD::grab(),
-                    [&](){
-                        if (args.size() != 1)
-                        {
-                            std::cout << "Error loading MATCHABLE_FWD(), expected 1 arg (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        grab(args[0]);
-                    }},
 
-                {MatchableKeyword::esc_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 1)
-                        {
-                            std::cout << "Error loading MATCHABLE(), expected >= 1 arg (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[0]);
-                        for (int i = 1; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx1_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 3)
-                        {
-                            std::cout << "Error loading PROPERTYx1_MATCHABLE(), expected >= 3 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[2]);
-                        m->add_property(args[0], args[1]);
-                        for (int i = 3; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx2_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 5)
-                        {
-                            std::cout << "Error loading PROPERTYx2_MATCHABLE(), expected >= 5 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[4]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        for (int i = 5; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx3_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 7)
-                        {
-                            std::cout << "Error loading PROPERTYx3_MATCHABLE(), expected >= 7 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[6]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        for (int i = 7; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx4_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 9)
-                        {
-                            std::cout << "Error loading PROPERTYx4_MATCHABLE(), expected >= 9 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[8]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        for (int i = 9; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx5_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 11)
-                        {
-                            std::cout << "Error loading PROPERTYx5_MATCHABLE(), expected >= 11 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[10]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        for (int i = 11; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx6_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 13)
-                        {
-                            std::cout << "Error loading PROPERTYx6_MATCHABLE(), expected >= 13 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[12]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        for (int i = 13; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx7_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 15)
-                        {
-                            std::cout << "Error loading PROPERTYx7_MATCHABLE(), expected >= 15 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[14]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        for (int i = 15; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx8_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 17)
-                        {
-                            std::cout << "Error loading PROPERTYx8_MATCHABLE(), expected >= 17 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[16]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        for (int i = 17; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx9_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 19)
-                        {
-                            std::cout << "Error loading PROPERTYx9_MATCHABLE(), expected >= 19 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[18]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        for (int i = 19; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx10_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 21)
-                        {
-                            std::cout << "Error loading PROPERTYx10_MATCHABLE(), expected >= 21 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[20]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        for (int i = 21; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx10_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 21)
-                        {
-                            std::cout << "Error loading PROPERTYx10_MATCHABLE(), expected >= 21 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[20]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        for (int i = 21; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx11_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 23)
-                        {
-                            std::cout << "Error loading PROPERTYx11_MATCHABLE(), expected >= 23 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[22]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        for (int i = 23; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx12_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 25)
-                        {
-                            std::cout << "Error loading PROPERTYx12_MATCHABLE(), expected >= 25 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[24]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        for (int i = 25; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx13_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 27)
-                        {
-                            std::cout << "Error loading PROPERTYx13_MATCHABLE(), expected >= 27 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[26]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        for (int i = 27; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx14_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 29)
-                        {
-                            std::cout << "Error loading PROPERTYx14_MATCHABLE(), expected >= 29 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[28]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        for (int i = 29; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx15_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 31)
-                        {
-                            std::cout << "Error loading PROPERTYx15_MATCHABLE(), expected >= 31 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[30]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        for (int i = 31; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx16_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 33)
-                        {
-                            std::cout << "Error loading PROPERTYx16_MATCHABLE(), expected >= 33 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[32]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        m->add_property(args[30], args[31]);
-                        for (int i = 33; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx17_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 35)
-                        {
-                            std::cout << "Error loading PROPERTYx17_MATCHABLE(), expected >= 35 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[34]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        m->add_property(args[30], args[31]);
-                        m->add_property(args[32], args[33]);
-                        for (int i = 35; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx18_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 37)
-                        {
-                            std::cout << "Error loading PROPERTYx18_MATCHABLE(), expected >= 37 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[36]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        m->add_property(args[30], args[31]);
-                        m->add_property(args[32], args[33]);
-                        m->add_property(args[34], args[35]);
-                        for (int i = 37; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx19_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 39)
-                        {
-                            std::cout << "Error loading PROPERTYx19_MATCHABLE(), expected >= 39 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[38]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        m->add_property(args[30], args[31]);
-                        m->add_property(args[32], args[33]);
-                        m->add_property(args[34], args[35]);
-                        m->add_property(args[36], args[37]);
-                        for (int i = 39; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx20_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 41)
-                        {
-                            std::cout << "Error loading PROPERTYx20_MATCHABLE(), expected >= 41 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[40]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        m->add_property(args[30], args[31]);
-                        m->add_property(args[32], args[33]);
-                        m->add_property(args[34], args[35]);
-                        m->add_property(args[36], args[37]);
-                        m->add_property(args[38], args[39]);
-                        for (int i = 41; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_PROPERTYx21_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 43)
-                        {
-                            std::cout << "Error loading PROPERTYx21_MATCHABLE(), expected >= 21 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[42]);
-                        m->add_property(args[0], args[1]);
-                        m->add_property(args[2], args[3]);
-                        m->add_property(args[4], args[5]);
-                        m->add_property(args[6], args[7]);
-                        m->add_property(args[8], args[9]);
-                        m->add_property(args[10], args[11]);
-                        m->add_property(args[12], args[13]);
-                        m->add_property(args[14], args[15]);
-                        m->add_property(args[16], args[17]);
-                        m->add_property(args[18], args[19]);
-                        m->add_property(args[20], args[21]);
-                        m->add_property(args[22], args[23]);
-                        m->add_property(args[24], args[25]);
-                        m->add_property(args[26], args[27]);
-                        m->add_property(args[28], args[29]);
-                        m->add_property(args[30], args[31]);
-                        m->add_property(args[32], args[33]);
-                        m->add_property(args[34], args[35]);
-                        m->add_property(args[36], args[37]);
-                        m->add_property(args[38], args[39]);
-                        m->add_property(args[40], args[41]);
-                        for (int i = 43; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_GROW_MATCHABLE::grab(),
-                    [&](){
-                        if (args.size() < 1)
-                        {
-                            std::cout << "Error loading GROW_MATCHABLE(), expected >= 1 arg (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[0]);
-                        for (int i = 1; i < (int) args.size(); ++i)
-                            m->add_variant(args[i]);
-                    }},
-
-                {MatchableKeyword::esc_MATCHABLE_VARIANT_PROPERTY_VALUE::grab(),
-                    [&](){
-                        if (args.size() != 4)
-                        {
-                            std::cout << "Error loading SET_PROPERTY(), expected 4 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[0]);
-                        m->set_property(args[1], args[2], args[3]);
-                    }},
+    save__status::Type MatchableMaker::save_each(
+        std::string const & directory,
+        save__content::Flags const & content,
+        save__grow_mode::Type mode
+    )
+    {
+        if (content.currently_set().size() == 0)
+            return save__status::no_content::grab();
 
-                {MatchableKeyword::esc_MATCHABLE_VARIANT_PROPERTY_VALUES::grab(),
-                    [&](){
-                        if (args.size() < 3)
-                        {
-                            std::cout << "Error loading SET_PROPERTY_VECT(), expected >= 3 args (got "
-                                      << args.size() << ")" << std::endl;
-                            ret = load__status::syntax_error::grab();
-                            return;
-                        }
-                        auto m = grab(args[0]);
-                        std::vector<std::string> property_values;
-                        for (int i = 3; i < (int) args.size(); ++i)
-                            property_values.push_back(args[i]);
-                        m->set_propertyvect(args[1], args[2], property_values);
-                    }},
-            });
+        if (mode.is_nil())
+            return save__status::no_grow_mode::grab();
+
+        save__status::Type ret{save__status::success::grab()};
+        auto header_of = [&](std::string const & name) { return directory + "/" + name + ".h"; };
+        static std::string const includes{
+            "#pragma once\n\n\n"
+            "#include <matchable/matchable.h>\n"
+            "#include <matchable/matchable_fwd.h>\n"
+        };
+
+        if (content.is_set(save__content::generated_matchable::grab()))
+        {
+            std::string header{includes + "\n\n\n"};
+            print_generated_matchable(mode, header);
+            if (!update_file(header_of("generated_matchable"), header))
+                return save__status::io_error::grab();
+        }
+
+        if (content.is_set(save__content::matchables::grab()))
+        {
+            // as with save_as(), matchables depending on a cycle are omitted unless just growing, since their
+            // headers would include each other
+            std::vector<Matchable const *> ordered;
+            if (mode != save__grow_mode::always::grab() && !order_by_dependencies(ordered))
+                ret = save__status::cyclic_dependencies::grab();
+            std::unordered_set<Matchable const *> const defined(ordered.begin(), ordered.end());
+
+            for (auto const & [name, m] : matchables)
+            {
+                if (ret == save__status::cyclic_dependencies::grab() && defined.count(m) == 0)
+                    continue;
+
+                // dependencies come and go with other matchables, so find them before skipping anything
+                std::set<std::string> dependencies;
+                for (auto const & [type, property_name] : m->property_types_and_names)
+                {
+                    Matchable const * dependency = matchable_dependency(matchables, type);
+                    if (nullptr != dependency && dependency != m)
+                        dependencies.insert(dependency->name);
+                }
+                std::string dependency_includes;
+                for (auto const & dependency : dependencies)
+                    dependency_includes += "#include \"" + dependency + ".h\"\n";
+
+                m->sync_variant_indexes();
+                std::string const filename = header_of(name);
+                std::error_code ec;
+                auto saved = saved_outputs.find(filename);
+                if (saved != saved_outputs.end() && saved->second.revision == m->revision &&
+                        saved->second.mode == mode &&
+                        saved->second.dependency_includes == dependency_includes &&
+                        std::filesystem::exists(filename, ec))
+                    continue;
+
+                std::string header{includes};
+                header.reserve(print_size(*m) + dependency_includes.size());
+                header += dependency_includes;
+                header += "\n\n\n";
+                if (mode != save__grow_mode::always::grab())
+                    print_matchable_fwd(*m, header);
+                print_matchable(*m, mode, header);
+                if (mode != save__grow_mode::table::grab())
+                    print_set_property(*m, header);
+
+                if (!update_file(filename, header))
+                    return save__status::io_error::grab();
+                SavedOutput & saved_output = saved_outputs[filename];
+                saved_output.revision = m->revision;
+                saved_output.mode = mode;
+                saved_output.dependency_includes = std::move(dependency_includes);
+            }
         }
 
-load_end:
-        fclose(f);
         return ret;
     }
 
 
-    std::string MatchableMaker::print_matchable_fwd(Matchable const & m)
+    bool MatchableMaker::update_file(std::string const & filename, std::string const & contents)
+    {
+        // FNV-1a
+        uint64_t hash{0xcbf29ce484222325};
+        for (unsigned char ch : contents)
+            hash = (hash ^ ch) * 0x100000001b3;
+
+        SavedOutput & saved = saved_outputs[filename];
+        std::error_code ec;
+        if (saved.hash == hash && std::filesystem::file_size(filename, ec) == contents.size() && !ec)
+            return true;
+
+        // the file may already hold the contents, saved by another maker or process
+        FileView existing;
+        if (!existing.open(filename) || existing.view() != contents)
+            if (!write_file(filename, contents))
+                return false;
+
+        saved.hash = hash;
+        return true;
+    }
+
+
+    size_t MatchableMaker::print_size(Matchable const & m)
     {
-        std::string ret{"MATCHABLE_FWD("};
-        ret += m.name;
-        ret += ")\n";
+        // name and separator per variant, plus a GROW_MATCHABLE(name) line per chunk
+        size_t ret{64 + m.name.size()};
+        for (auto const & [t, n] : m.property_types_and_names)
+            ret += t.size() + n.size() + 4;
+        ret += (m.variants.size() / 16 + 1) * (m.name.size() + 17);
+        for (auto const & variant : m.variants)
+        {
+            ret += variant.variant_name.size() + 2;
+            for (size_t p = 0; p < variant.properties.size() && p < m.property_types_and_names.size(); ++p)
+            {
+                auto const & [s_value, s_values] = variant.properties[p];
+                std::string const & s_name = m.property_types_and_names[p].second;
+                size_t const prefix_size = 48 + m.name.size() + variant.variant_name.size() + s_name.size();
+                if (s_value.size() > 0)
+                    ret += prefix_size + s_value.size();
+                if (s_values.size() > 0)
+                {
+                    ret += prefix_size + (s_values.size() / 17) * 18;
+                    for (auto const & v : s_values)
+                        ret += v.size() + 2;
+                }
+            }
+        }
+        // table form: quotes, sort order and positions per variant, declarations of columns per property
+        ret += m.variants.size() * 16;
+        ret += m.property_types_and_names.size() * (512 + 12 * m.name.size());
         return ret;
     }
 
 
-    std::string MatchableMaker::print_matchable(
+    void MatchableMaker::print_generated_matchable(save__grow_mode::Type mode, std::string & out)
+    {
+        Matchable generated;
+        generated.name = "generated_matchable";
+        generated.variants.reserve(matchables.size());
+        for (auto const & [name, m] : matchables)
+            generated.variants.emplace_back(name);
+        out.reserve(out.size() + print_size(generated));
+        print_matchable(generated, mode, out);
+    }
+
+
+    void MatchableMaker::print_matchable_fwd(Matchable const & m, std::string & out)
+    {
+        out += "MATCHABLE_FWD(";
+        out += m.name;
+        out += ")\n";
+    }
+
+
+    void MatchableMaker::print_matchable_declaration(Matchable const & m, std::string & out)
+    {
+        if (m.property_types_and_names.size() > 0)
+        {
+            out += "PROPERTYx";
+            out += std::to_string(m.property_types_and_names.size());
+            out += "_";
+        }
+        out += "MATCHABLE(";
+        for (auto const & [t, n] : m.property_types_and_names)
+        {
+            out += t;
+            out += ", ";
+            out += n;
+            out += ", ";
+        }
+        out += m.name;
+        out += ")\n";
+    }
+
+
+    void MatchableMaker::print_matchable(
         matchable::Matchable const & m,
-        save__grow_mode::Type mode
+        save__grow_mode::Type mode,
+        std::string & out
     )
     {
-        std::string ret;
-
         if (mode.is_nil())
-            return ret;
+            return;
+
+        if (mode == save__grow_mode::table::grab())
+        {
+            print_matchable_table(m, out);
+            return;
+        }
 
         if (mode == save__grow_mode::wrap::grab())
         {
-            if (m.property_types_and_names.size() > 0)
-            {
-                ret += "PROPERTYx";
-                ret += std::to_string(m.property_types_and_names.size());
-                ret += "_";
-            }
-            ret += "MATCHABLE(";
-            for (auto const & [t, n] : m.property_types_and_names)
-            {
-                ret += t;
-                ret += ", ";
-                ret += n;
-                ret += ", ";
-            }
+            // the declaration without its closing parenthesis, followed by the variants
+            print_matchable_declaration(m, out);
+            out.resize(out.size() - 2);
         }
         else if (mode == save__grow_mode::always::grab())
         {
-            ret += "GROW_MATCHABLE(";
+            out += "GROW_MATCHABLE(";
+            out += m.name;
         }
         else
         {
             // unhandled mode
             assert(107);
         }
-        ret += m.name;
         int variant_count{0};
         for (auto const & v : m.variants)
         {
             ++variant_count;
             if (variant_count % 17 == 0)
             {
-                ret += ")\nGROW_MATCHABLE(";
-                ret += m.name;
+                out += ")\nGROW_MATCHABLE(";
+                out += m.name;
             }
 
-            ret += ", ";
-            ret += v.variant_name;
+            out += ", ";
+            out += v.variant_name;
         }
-        ret += ")\n";
+        out += ")\n";
+    }
 
-        return ret;
+
+    void MatchableMaker::print_matchable_table(Matchable const & m, std::string & out)
+    {
+        print_matchable_declaration(m, out);
+        if (m.variants.size() == 0)
+            return;
+
+        // the by string order is verified when registering, so it only needs to agree with matchable.h
+        std::vector<std::string> strings;
+        strings.reserve(m.variants.size());
+        for (auto const & v : m.variants)
+        {
+            std::string & unescaped = strings.emplace_back();
+            escapable::unescape_each(v.variant_name, [&unescaped](char c) { unescaped.push_back(c); });
+        }
+        std::vector<int> order(m.variants.size());
+        for (int i = 0; i < (int) order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(
+            order.begin(),
+            order.end(),
+            [&strings](int a, int b) { return str_lt_str(strings[a], strings[b]); }
+        );
+
+        auto print_list = [&out](auto const & items, auto print_item)
+        {
+            int item_count{0};
+            for (auto const & item : items)
+            {
+                out += item_count % 16 == 0 ? "\n        " : " ";
+                print_item(item);
+                out += ",";
+                ++item_count;
+            }
+            out += "\n    };\n";
+        };
+        auto print_int = [&out](int i) { out += std::to_string(i); };
+
+        out += "namespace ";
+        out += m.name;
+        out += "\n{\n    inline char const * const table_identifiers[] = {";
+        print_list(
+            m.variants,
+            [&out](MatchableVariant const & v)
+            {
+                out += "\"";
+                out += v.variant_name;
+                out += "\"";
+            }
+        );
+        out += "    inline constexpr int table_by_string_order[] = {";
+        print_list(order, print_int);
+        out += "    inline std::vector<Type> const table_variants =\n"
+               "        ::matchable::register_variant_table<Type>(\n"
+               "            table_identifiers,\n"
+               "            table_by_string_order\n"
+               "        );\n";
+
+        // columns of positions and value indexes per property, skipping empty columns
+        //   - each distinct value is printed once, keeping the dynamic initialization the compiler has to
+        //     generate for values of class type proportional to the number of distinct values
+        struct DistinctValues
+        {
+            int index_of(std::pmr::string const & value)
+            {
+                auto [iter, inserted] = indexes.try_emplace(value, (int) values.size());
+                if (inserted)
+                    values.push_back(&value);
+                return iter->second;
+            }
+            std::unordered_map<std::string_view, int> indexes;
+            std::vector<std::pmr::string const *> values;
+        };
+        for (size_t p = 0; p < m.property_types_and_names.size(); ++p)
+        {
+            auto const & [type, property_name] = m.property_types_and_names[p];
+            std::vector<int> positions;
+            std::vector<int> value_indexes;
+            DistinctValues values;
+            std::vector<int> vect_positions;
+            std::vector<int> vect_offsets{0};
+            std::vector<int> vect_value_indexes;
+            DistinctValues vect_values;
+            for (int i = 0; i < (int) m.variants.size(); ++i)
+            {
+                if (p >= m.variants[i].properties.size())
+                    continue;
+                auto const & [s_value, s_values] = m.variants[i].properties[p];
+                if (s_value.size() > 0)
+                {
+                    positions.push_back(i);
+                    value_indexes.push_back(values.index_of(s_value));
+                }
+                if (s_values.size() > 0)
+                {
+                    vect_positions.push_back(i);
+                    for (auto const & v : s_values)
+                        vect_value_indexes.push_back(vect_values.index_of(v));
+                    vect_offsets.push_back((int) vect_value_indexes.size());
+                }
+            }
+            auto print_value = [&out](std::pmr::string const * value) { print_table_value(*value, out); };
+            std::string const prefix{"    inline "};
+            std::string const table_p{"table_" + property_name};
+
+            if (positions.size() > 0)
+            {
+                out += prefix + "constexpr int " + table_p + "_positions[] = {";
+                print_list(positions, print_int);
+                out += prefix + "constexpr int " + table_p + "_value_indexes[] = {";
+                print_list(value_indexes, print_int);
+                out += prefix + type + " const " + table_p + "_values[] = {";
+                print_list(values.values, print_value);
+                out += prefix + "bool const " + table_p + "_set =\n"
+                       "        ::matchable::set_property_column(\n"
+                       "            table_variants,\n"
+                       "            " + table_p + "_positions,\n"
+                       "            " + table_p + "_value_indexes,\n"
+                       "            " + table_p + "_values,\n"
+                       "            [](Type v, auto const & value) { v.set_" + property_name +
+                       "(value); }\n"
+                       "        );\n";
+            }
+            if (vect_positions.size() > 0)
+            {
+                out += prefix + "constexpr int " + table_p + "_vect_positions[] = {";
+                print_list(vect_positions, print_int);
+                out += prefix + "constexpr int " + table_p + "_vect_offsets[] = {";
+                print_list(vect_offsets, print_int);
+                out += prefix + "constexpr int " + table_p + "_vect_value_indexes[] = {";
+                print_list(vect_value_indexes, print_int);
+                out += prefix + type + " const " + table_p + "_vect_values[] = {";
+                print_list(vect_values.values, print_value);
+                out += prefix + "bool const " + table_p + "_vect_set =\n"
+                       "        ::matchable::set_property_vect_column(\n"
+                       "            table_variants,\n"
+                       "            " + table_p + "_vect_positions,\n"
+                       "            " + table_p + "_vect_offsets,\n"
+                       "            " + table_p + "_vect_value_indexes,\n"
+                       "            " + table_p + "_vect_values,\n"
+                       "            [](Type v, auto const & values) { v.set_" + property_name +
+                       "_vect(values); }\n"
+                       "        );\n";
+            }
+        }
+        out += "}\n";
     }
 
 
-    std::string MatchableMaker::print_set_property(Matchable const & m)
+    void MatchableMaker::print_set_property(Matchable const & m, std::string & out)
     {
-        std::string ret;
         for (auto const & variant : m.variants)
         {
-            for (auto const & [s_name, s_value, s_values] : variant.properties)
+            for (size_t p = 0; p < variant.properties.size() && p < m.property_types_and_names.size(); ++p)
             {
+                auto const & [s_value, s_values] = variant.properties[p];
+                std::string const & s_name = m.property_types_and_names[p].second;
                 if (s_value.size() > 0)
                 {
-                    ret += "MATCHABLE_VARIANT_PROPERTY_VALUE(";
-                    ret += m.name;
-                    ret += ", ";
-                    ret += variant.variant_name;
-                    ret += ", ";
-                    ret += s_name;
-                    ret += ", ";
-                    ret += s_value;
-                    ret += ")\n";
+                    out += "MATCHABLE_VARIANT_PROPERTY_VALUE(";
+                    out += m.name;
+                    out += ", ";
+                    out += variant.variant_name;
+                    out += ", ";
+                    out += s_name;
+                    out += ", ";
+                    out += s_value;
+                    out += ")\n";
                 }
                 if (s_values.size() > 0)
                 {
-                    ret += "MATCHABLE_VARIANT_PROPERTY_VALUES(";
-                    ret += m.name;
-                    ret += ", ";
-                    ret += variant.variant_name;
-                    ret += ", ";
-                    ret += s_name;
+                    out += "MATCHABLE_VARIANT_PROPERTY_VALUES(";
+                    out += m.name;
+                    out += ", ";
+                    out += variant.variant_name;
+                    out += ", ";
+                    out += s_name;
                     int element_count{0};
                     for (auto const & v : s_values)
                     {
                         ++element_count;
                         if (element_count % 17 == 0)
-                            ret += ",\n                  ";
+                            out += ",\n                  ";
                         else
-                            ret += ", ";
-                        ret += v;
+                            out += ", ";
+                        out += v;
                     }
-                    ret += ")\n";
+                    out += ")\n";
                 }
             }
         }
-
-        return ret;
     }
 }
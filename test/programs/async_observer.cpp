@@ -0,0 +1,175 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "matchable/async_observers.h"
+#include "matchable/matchable.h"
+#include "test_ok.h"
+
+
+
+PROPERTYx1_MATCHABLE(int, level, Sensor, Temperature, Pressure, Humidity, Wind)
+
+
+
+int main()
+{
+    test_ok ok;
+
+    // observers run on the pool, notifications for each variant arrive in order
+    {
+        std::mutex m;
+        std::vector<char> temperature_log;
+        int pressure_count{0};
+        bool observed_on_main_thread{false};
+        auto const main_id = std::this_thread::get_id();
+
+        auto temperature = Sensor::Temperature::grab();
+        auto pressure = Sensor::Pressure::grab();
+        temperature.add_level_observer(
+            [&]()
+            {
+                std::lock_guard<std::mutex> lock{m};
+                temperature_log.push_back('A');
+                observed_on_main_thread |= std::this_thread::get_id() == main_id;
+            }
+        );
+        temperature.add_level_observer(
+            [&]()
+            {
+                std::lock_guard<std::mutex> lock{m};
+                temperature_log.push_back('B');
+            }
+        );
+        pressure.add_level_observer(
+            [&]()
+            {
+                std::lock_guard<std::mutex> lock{m};
+                ++pressure_count;
+                observed_on_main_thread |= std::this_thread::get_id() == main_id;
+            }
+        );
+
+        matchable::AsyncObserverPool pool{4};
+        for (int i = 0; i < 100; ++i)
+        {
+            temperature.set_level(i);
+            pressure.set_level(i);
+        }
+        pool.drain();
+
+        TEST_EQ(ok, temperature_log.size(), (size_t) 200);
+        TEST_EQ(ok, pressure_count, 100);
+        TEST_EQ(ok, observed_on_main_thread, false);
+        for (size_t i = 0; i < temperature_log.size(); ++i)
+            TEST_EQ(ok, temperature_log[i], i % 2 == 0 ? 'A' : 'B');
+        TEST_EQ(ok, temperature.as_level(), 99);
+    }
+
+    // without a pool observers run inline again
+    {
+        bool called{false};
+        auto humidity = Sensor::Humidity::grab();
+        humidity.add_level_observer([&](){ called = true; });
+        humidity.set_level(7);
+        TEST_EQ(ok, called, true);
+    }
+
+    // nil
+    {
+        int calls{0};
+        {
+            matchable::AsyncObserverPool pool;
+            Sensor::nil.add_level_observer([&](){ ++calls; });
+            Sensor::nil.set_level(1);
+            Sensor::nil.set_level(2);
+        }
+        TEST_EQ(ok, calls, 2);
+        TEST_EQ(ok, Sensor::nil.as_level(), 2);
+    }
+
+    // pools come and go while another thread keeps setting, every notification is delivered once
+    {
+        std::atomic<int> calls{0};
+        Sensor::Wind::grab().add_level_observer([&](){ ++calls; });
+
+        std::atomic<bool> setting{true};
+        int sets{0};
+        std::thread setter{
+            [&]()
+            {
+                auto wind = Sensor::Wind::grab();
+                while (setting)
+                {
+                    wind.set_level(sets);
+                    ++sets;
+                }
+            }
+        };
+        for (int i = 0; i < 200; ++i)
+            matchable::AsyncObserverPool pool{2};
+        setting = false;
+        setter.join();
+
+        TEST_EQ(ok, calls.load(), sets);
+    }
+
+    // uninstalling a dispatcher and waiting returns only once setters already within its dispatch() are done
+    {
+        struct GatedDispatcher : matchable::ObserverDispatcher
+        {
+            void dispatch(matchable::ObserverKey, std::vector<std::function<void ()>> const &) override
+            {
+                entered = true;
+                while (!released)
+                    std::this_thread::yield();
+            }
+            std::atomic<bool> entered{false};
+            std::atomic<bool> released{false};
+        } gate;
+
+        auto * prev = matchable::observer_dispatcher().exchange(&gate);
+        std::thread setter{[](){ Sensor::Wind::grab().set_level(-1); }};
+        while (!gate.entered)
+            std::this_thread::yield();
+        matchable::observer_dispatcher().store(prev);
+
+        std::atomic<bool> waited{false};
+        std::thread waiter{[&](){ matchable::wait_for_observer_dispatches(); waited = true; }};
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        TEST_EQ(ok, waited.load(), false);
+        gate.released = true;
+        setter.join();
+        waiter.join();
+        TEST_EQ(ok, waited.load(), true);
+    }
+
+    // keys identify the property and variant independently of where their observers are stored
+    {
+        struct RecordingDispatcher : matchable::ObserverDispatcher
+        {
+            void dispatch(matchable::ObserverKey key, std::vector<std::function<void ()>> const &) override
+                { keys.push_back(key); }
+            std::vector<matchable::ObserverKey> keys;
+        } recorder;
+
+        auto * prev = matchable::observer_dispatcher().exchange(&recorder);
+        Sensor::Temperature::grab().set_level(1);
+        Sensor::Pressure::grab().set_level(1);
+        Sensor::Temperature::grab().set_level(2);
+        Sensor::nil.set_level(3);
+        matchable::observer_dispatcher().store(prev);
+
+        TEST_EQ(ok, recorder.keys.size(), (size_t) 4);
+        TEST_EQ(ok, recorder.keys[0] == recorder.keys[2], true);
+        TEST_EQ(ok, recorder.keys[0].property == recorder.keys[1].property, true);
+        TEST_EQ(ok, recorder.keys[0].variant, matchable::property_table_index(Sensor::Temperature::grab()));
+        TEST_NE(ok, recorder.keys[0].variant, recorder.keys[1].variant);
+        TEST_EQ(ok, recorder.keys[3].variant, -1);
+    }
+
+    return ok();
+}
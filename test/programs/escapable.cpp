@@ -112,6 +112,15 @@ MATCHABLE(
 )
 
 
+MATCHABLE(Complexity, O_parl_n_spc_log_parl_n_parr__parr_)
+MATCHABLE(escapable, keep_spc_escaped)
+
+
+// variant strings are unescaped at compile time
+static_assert(special::esc_and_eq::as_string_view() == "and_eq");
+static_assert(Complexity::O_parl_n_spc_log_parl_n_parr__parr_::as_string_view() == "O(n log(n))");
+static_assert(escapable::keep_spc_escaped::as_string_view() == "keep_spc_escaped");
+
 
 int main()
 {
@@ -131,7 +140,13 @@ int main()
 
     std::cout << "\nescape codes:" << std::endl;
     for (auto const & [code, symbol] : matchable::escapable::code_symbol_pairs())
+    {
         std::cout << "    " << code << " matches '" << symbol << "'" << std::endl;
+        TEST_EQ(ok, matchable::escapable::escape(symbol), code);
+        TEST_EQ(ok, matchable::escapable::unescape(code), symbol);
+    }
+    TEST_EQ(ok, matchable::escapable::code_symbol_pairs().size(), matchable::escapable::codes.size());
+    TEST_EQ(ok, matchable::escapable::unescape("_foo_"), std::string("_foo_"));
 
     auto s = special::from_string("xor_eq");
     TEST_EQ(ok, s, special::esc_xor_eq::grab());
@@ -146,5 +161,19 @@ int main()
     esc = "s";
     TEST_EQ(ok, esc, matchable::escapable::escape(esc));
 
+    TEST_EQ(ok, matchable::escapable::unescape_all("O_parl_log_parl_n_parr__parr_"), std::string("O(log(n))"));
+    TEST_EQ(ok, matchable::escapable::unescape_all("a_spc_b_foo_c_dot_"), std::string("a b_foo_c."));
+    TEST_EQ(ok, matchable::escapable::unescape_all("_atsym__bslsh__"), std::string("@\\_"));
+
+    std::string printable;
+    for (char c = ' '; c < 127; ++c)
+        printable += c;
+    TEST_EQ(ok, matchable::escapable::unescape_all(matchable::escapable::escape_all(printable)), printable);
+
+    // appending to a caller provided buffer
+    std::string buffer{"prefix_"};
+    matchable::escapable::escape_all(std::string_view("a b(c)"), buffer);
+    TEST_EQ(ok, buffer, std::string("prefix_a_spc_b_parl_c_parr_"));
+
     return ok();
 }
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "matchable/matchable.h"
+#include "test_ok.h"
+
+
+
+MATCHABLE(Unit, Celsius, Kelvin)
+PROPERTYx2_MATCHABLE(int, boiling_point, Unit::Type, unit, Liquid, Water, Ethanol, Mercury)
+MATCHABLE_VARIANT_PROPERTY_VALUE(Liquid, Water, boiling_point, 100)
+MATCHABLE_VARIANT_PROPERTY_VALUE(Liquid, Ethanol, boiling_point, 78)
+MATCHABLE_VARIANT_PROPERTY_VALUE(Liquid, Mercury, boiling_point, 357)
+MATCHABLE_VARIANT_PROPERTY_VALUES(Liquid, Water, unit, Unit::Celsius::grab(), Unit::Kelvin::grab())
+
+PROPERTYx1_MATCHABLE(int, cost, Material, Wood, Steel)
+
+
+
+// run f in a child process, returning true if the child aborted
+template<typename F>
+bool aborts(F f)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        f();
+        _exit(0);
+    }
+    int status{0};
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    TEST_EQ(ok, Liquid::is_frozen(), false);
+    Liquid::Ethanol::grab().set_boiling_point(79);
+    Liquid::freeze();
+    TEST_EQ(ok, Liquid::is_frozen(), true);
+    TEST_EQ(ok, Material::is_frozen(), false);
+
+    // concurrent reads of frozen properties
+    {
+        std::vector<int> sums(8, 0);
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < sums.size(); ++i)
+            readers.emplace_back(
+                [&sums, i]()
+                {
+                    for (int j = 0; j < 1000; ++j)
+                        for (auto l : Liquid::variants())
+                            sums[i] += l.as_boiling_point() + (int) l.as_unit_vect().size();
+                }
+            );
+        for (auto & r : readers)
+            r.join();
+        for (auto s : sums)
+            TEST_EQ(ok, s, 1000 * (100 + 79 + 357 + 2));
+    }
+
+    // setters fail fast once frozen
+    TEST_EQ(ok, aborts([](){ Liquid::Water::grab().set_boiling_point(0); }), true);
+    TEST_EQ(ok, aborts([](){ Liquid::Water::grab().set_unit_vect({}); }), true);
+    TEST_EQ(ok, aborts([](){ Liquid::Water::grab().as_mutable_boiling_point() = 0; }), true);
+    TEST_EQ(ok, aborts([](){ Liquid::nil.set_boiling_point(0); }), true);
+    TEST_EQ(ok, aborts([](){ Liquid::Water::grab().add_unit_observer([](){}); }), true);
+    TEST_EQ(ok, aborts([](){ Material::Wood::grab().set_cost(3); }), false);
+
+    // freeze everything
+    Material::Steel::grab().set_cost(12);
+    matchable::freeze_all();
+    TEST_EQ(ok, Material::is_frozen(), true);
+    TEST_EQ(ok, Material::Steel::grab().as_cost(), 12);
+    TEST_EQ(ok, aborts([](){ Material::Wood::grab().set_cost(3); }), true);
+
+    return ok();
+}
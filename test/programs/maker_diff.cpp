@@ -0,0 +1,177 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+// changes one per line as kind matchable.variant.property
+static std::string listed(std::vector<matchable::MatchableChange> const & changes)
+{
+    std::string ret;
+    for (auto const & c : changes)
+        ret += c.kind.as_string() + " " + c.matchable + "." + c.variant + "." + c.property + "\n";
+    return ret;
+}
+
+
+static void populate(matchable::MatchableMaker & maker)
+{
+    auto fruit = maker.grab("Fruit");
+    fruit->add_property("std::string", "color");
+    fruit->add_property("int", "seeds");
+    for (auto const & v : {"apple", "banana", "cherry", "date", "elder", "grape", "kiwi"})
+        fruit->add_variant(v);
+    fruit->set_property("apple", "color", "red");
+    fruit->set_property("apple", "seeds", "5");
+    fruit->set_property("banana", "seeds", "0");
+
+    maker.grab("Tool")->add_variant("hammer");
+}
+
+
+static std::string property(matchable::Matchable * m, std::string const & variant, std::string const & p)
+{
+    std::string value;
+    m->get_property(variant, p, value);
+    return value;
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    // diff lists matchables in name order, each with its property declarations followed by its variants
+    {
+        matchable::MatchableMaker before;
+        populate(before);
+        before.grab("Old")->add_variant("o");
+
+        matchable::MatchableMaker after;
+        populate(after);
+        auto fruit = after.grab("Fruit");
+        fruit->property_types_and_names[0].first = "Color::Type";
+        fruit->add_property("int", "weight");
+        fruit->set_property("apple", "seeds", "6");
+        fruit->set_property("banana", "seeds", "");
+        fruit->set_property("cherry", "color", "red");
+        fruit->del_variant("date");
+        fruit->add_variant("fig");
+        fruit->set_property("fig", "weight", "1");
+        after.grab("New")->add_variant("n");
+
+        TEST_EQ(ok, before.diff(before).size(), (size_t) 0);
+        TEST_EQ(
+            ok,
+            listed(before.diff(after)),
+            std::string(
+                "changed Fruit..color\n"
+                "added Fruit..weight\n"
+                "changed Fruit.apple.seeds\n"
+                "removed Fruit.banana.seeds\n"
+                "added Fruit.cherry.color\n"
+                "removed Fruit.date.\n"
+                "added Fruit.fig.\n"
+                "added New..\n"
+                "removed Old..\n"
+            )
+        );
+
+        // and the other way round
+        TEST_EQ(
+            ok,
+            listed(after.diff(before)),
+            std::string(
+                "changed Fruit..color\n"
+                "removed Fruit..weight\n"
+                "changed Fruit.apple.seeds\n"
+                "added Fruit.banana.seeds\n"
+                "removed Fruit.cherry.color\n"
+                "removed Fruit.fig.\n"
+                "added Fruit.date.\n"
+                "removed New..\n"
+                "added Old..\n"
+            )
+        );
+    }
+
+    // three-way merge
+    {
+        matchable::MatchableMaker base;
+        populate(base);
+        base.grab("Gone")->add_variant("g");
+        base.grab("Old")->add_variant("o");
+        base.grab("Older")->add_variant("o");
+
+        matchable::MatchableMaker mine;
+        populate(mine);
+        auto fruit = mine.grab("Fruit");
+        fruit->set_property("apple", "seeds", "6");
+        fruit->set_property("banana", "color", "yellow");
+        fruit->set_property("date", "seeds", "3");
+        fruit->set_property("grape", "seeds", "9");
+        fruit->del_variant("kiwi");
+        mine.grab("Old")->add_variant("o");
+        mine.grab("Older")->add_variant("o");
+        mine.grab("Older")->add_variant("o2");
+
+        matchable::MatchableMaker theirs;
+        populate(theirs);
+        auto their_fruit = theirs.grab("Fruit");
+        their_fruit->add_property("int", "weight");
+        their_fruit->set_property("banana", "color", "yellow");
+        their_fruit->set_property("cherry", "seeds", "2");
+        their_fruit->set_property("date", "seeds", "4");
+        their_fruit->set_property("kiwi", "seeds", "1");
+        their_fruit->del_variant("elder");
+        their_fruit->del_variant("grape");
+        their_fruit->add_variant("fig");
+        their_fruit->set_property("fig", "weight", "1");
+        theirs.grab("Gone")->add_variant("g");
+        theirs.grab("Gone")->add_variant("g2");
+        theirs.grab("New")->add_variant("n");
+
+        // a change on each side of the same value, or a removal on one side of what the other changed,
+        // conflicts and keeps this maker's version
+        TEST_EQ(
+            ok,
+            listed(mine.merge(base, theirs)),
+            std::string(
+                "added Fruit.date.seeds\n"
+                "changed Fruit.kiwi.\n"
+                "removed Fruit.grape.\n"
+                "changed Gone..\n"
+                "removed Older..\n"
+            )
+        );
+
+        // changes made on one side only, or the same on both, are taken
+        TEST_EQ(ok, mine.grab("Fruit"), fruit);
+        TEST_EQ(ok, property(fruit, "apple", "seeds"), std::string("6"));
+        TEST_EQ(ok, property(fruit, "banana", "color"), std::string("yellow"));
+        TEST_EQ(ok, property(fruit, "cherry", "seeds"), std::string("2"));
+        TEST_EQ(ok, property(fruit, "date", "seeds"), std::string("3"));
+        TEST_EQ(ok, property(fruit, "fig", "weight"), std::string("1"));
+        TEST_EQ(ok, property(fruit, "grape", "seeds"), std::string("9"));
+        TEST_EQ(ok, fruit->has_variant("elder"), false);
+        TEST_EQ(ok, fruit->has_variant("kiwi"), false);
+        TEST_EQ(ok, fruit->property_types_and_names.back().second, std::string("weight"));
+
+        // matchables added by theirs are added, those removed by theirs only where unchanged here
+        TEST_EQ(ok, mine.matchables.count("New"), (size_t) 1);
+        TEST_EQ(ok, mine.matchables.count("Gone"), (size_t) 0);
+        TEST_EQ(ok, mine.matchables.count("Old"), (size_t) 0);
+        TEST_EQ(ok, mine.matchables.count("Older"), (size_t) 1);
+        TEST_EQ(ok, mine.grab("New")->has_variant("n"), true);
+
+        // merging again only repeats the conflicts
+        TEST_EQ(ok, mine.merge(base, theirs).size(), (size_t) 5);
+        TEST_EQ(ok, property(fruit, "date", "seeds"), std::string("3"));
+    }
+
+    return ok();
+}
@@ -0,0 +1,235 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+static std::string read_file(std::filesystem::path const & filename)
+{
+    std::ifstream f{filename};
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+
+static bool contains(std::string const & s, std::string const & part)
+{
+    return s.find(part) != std::string::npos;
+}
+
+
+static std::string property(matchable::Matchable * m, std::string const & variant, std::string const & p)
+{
+    std::string value;
+    m->get_property(variant, p, value);
+    return value;
+}
+
+
+static matchable::save__content::Flags content_of_matchables()
+{
+    matchable::save__content::Flags content;
+    content.set(matchable::save__content::matchables::grab());
+    return content;
+}
+
+
+static matchable::load__status::Type import(
+    matchable::MatchableMaker & maker,
+    std::string const & m,
+    std::string const & text,
+    matchable::import__format::Type format
+)
+{
+    std::istringstream in{text};
+    return maker.import_variants(m, in, format);
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    auto const dir = std::filesystem::temp_directory_path() / "matchable_test_maker_import";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto const csv = matchable::import__format::csv::grab();
+    auto const tsv = matchable::import__format::tsv::grab();
+    auto const jsonl = matchable::import__format::jsonl::grab();
+    auto const success = matchable::load__status::success::grab();
+    auto const syntax_error = matchable::load__status::syntax_error::grab();
+
+    // csv, with quoted fields spanning lines and escaped quotes
+    {
+        matchable::MatchableMaker maker;
+        auto animal = maker.grab("Animal");
+        animal->add_property("int", "legs");
+        animal->add_property("std::string", "sound");
+        TEST_EQ(
+            ok,
+            import(maker, "Animal", "name,legs,sound\r\ncat,4,\"\"\"meow\"\"\"\nspider-monkey,,\"oo\nh\"\n", csv),
+            success
+        );
+        TEST_EQ(ok, animal->variants.size(), (size_t) 2);
+        TEST_EQ(ok, property(animal, "cat", "legs"), std::string("4"));
+        TEST_EQ(ok, property(animal, "cat", "sound"), std::string("\"meow\""));
+        TEST_EQ(ok, property(animal, "spider_mns_monkey", "legs"), std::string());
+        TEST_EQ(ok, property(animal, "spider_mns_monkey", "sound"), std::string("oo\nh"));
+
+        // variants already present are updated
+        TEST_EQ(ok, import(maker, "Animal", "name\tlegs\ncat\t3\nant\t6\n", tsv), success);
+        TEST_EQ(ok, animal->variants.size(), (size_t) 3);
+        TEST_EQ(ok, property(animal, "cat", "legs"), std::string("3"));
+        TEST_EQ(ok, property(animal, "cat", "sound"), std::string("\"meow\""));
+    }
+
+    // jsonl
+    {
+        matchable::MatchableMaker maker;
+        auto fruit = maker.grab("Fruit");
+        fruit->add_property("Color::Type", "color");
+        fruit->add_property("int", "seeds");
+        std::string const text{
+            "{\"name\": \"apple\", \"seeds\": 5, \"color\": [\"Color::Red::grab()\", \"Color::Green::grab()\"]}\n"
+            "\n"
+            "{\"name\": \"kiwi fruit\", \"seeds\": null}\n"
+            "{\"name\": \"caf\\u00e9\"}\n"
+        };
+        TEST_EQ(ok, import(maker, "Fruit", text.substr(0, text.rfind("{")), jsonl), success);
+        TEST_EQ(ok, property(fruit, "apple", "seeds"), std::string("5"));
+        std::vector<std::string> colors;
+        fruit->get_propertyvect("apple", "color", colors);
+        TEST_EQ(ok, colors.size(), (size_t) 2);
+        TEST_EQ(ok, fruit->has_variant("kiwi_spc_fruit"), true);
+        TEST_EQ(ok, property(fruit, "kiwi_spc_fruit", "seeds"), std::string());
+
+        // names beyond what can be escaped
+        TEST_EQ(ok, import(maker, "Fruit", text, jsonl), syntax_error);
+        TEST_EQ(ok, fruit->variants.size(), (size_t) 2);
+    }
+
+    // variant names that are not identifiers as they are
+    {
+        matchable::MatchableMaker maker;
+        TEST_EQ(ok, import(maker, "Word", "name\n17\nclass\nesc_x\ngrab\nx_y\n", csv), success);
+        std::vector<std::string> names;
+        for (auto const & v : maker.grab("Word")->variants)
+            names.emplace_back(v.variant_name);
+        std::vector<std::string> const truth{"esc_17", "esc_class", "esc_esc_x", "esc_grab", "x_y"};
+        TEST_EQ(ok, names == truth, true);
+        for (auto const & name : names)
+            std::cout << name << " -> " << matchable::escapable::unescape_all(name) << std::endl;
+        TEST_EQ(ok, matchable::escapable::unescape_all("esc_esc_x"), std::string("esc_x"));
+        TEST_EQ(ok, import(maker, "Word", "name\ntab\there\n", csv), syntax_error);
+        TEST_EQ(ok, maker.grab("Word")->variants.size(), (size_t) 5);
+    }
+
+    // names the generated header defines itself, and reserved identifiers
+    {
+        matchable::MatchableMaker maker;
+        auto word = maker.grab("Word");
+        word->add_property("int", "n");
+        std::string const text{"name,n\nType,1\nFlags,2\nMatchableType,3\nIWord,4\nIOther,5\n_Up,6\na__b,7\n_low,8\n"};
+        TEST_EQ(ok, import(maker, "Word", text, csv), success);
+        std::vector<std::string> names;
+        for (auto const & v : word->variants)
+            names.emplace_back(v.variant_name);
+        std::vector<std::string> const truth{
+            "esc_Type", "esc_Flags", "esc_MatchableType", "esc_IWord", "IOther", "esc__Up", "esc_a__b", "_low"
+        };
+        TEST_EQ(ok, names == truth, true);
+
+        // import -> save -> compile, checking each name survives the round trip
+        auto const header = dir / "word.h";
+        TEST_EQ(
+            ok,
+            maker.save_as(header.string(), content_of_matchables(), matchable::save__grow_mode::wrap::grab()),
+            matchable::save__status::success::grab()
+        );
+#ifdef MATCHABLE_TEST_CXX
+        if (std::filesystem::exists(MATCHABLE_TEST_CXX))
+        {
+            std::ofstream use{dir / "use_word.cpp"};
+            use << "#include \"word.h\"\n";
+            for (auto const & name : names)
+                use << "static_assert(Word::" << name << "::as_string_view() == \""
+                    << matchable::escapable::unescape_all(name) << "\");\n";
+            use.close();
+            std::string const command{
+                std::string(MATCHABLE_TEST_CXX) + " -std=c++20 -fsyntax-only -I" + MATCHABLE_TEST_INCLUDE +
+                " -I" + dir.string() + " " + (dir / "use_word.cpp").string()
+            };
+            TEST_EQ(ok, std::system(command.c_str()), 0);
+        }
+        else
+        {
+            std::cout << "compiler " << MATCHABLE_TEST_CXX << " not found, saved header not compiled" << std::endl;
+        }
+#endif
+    }
+
+    // import -> save_each -> load
+    {
+        matchable::MatchableMaker maker;
+        auto c = maker.grab("C");
+        c->add_property("int", "n");
+        TEST_EQ(ok, import(maker, "C", "name,n\na,1\nb,2\n", csv), success);
+
+        matchable::save__content::Flags content;
+        content.set(matchable::save__content::matchables::grab());
+        auto const wrap = matchable::save__grow_mode::wrap::grab();
+        TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+        TEST_EQ(ok, contains(read_file(dir / "C.h"), "MATCHABLE_VARIANT_PROPERTY_VALUE(C, b, n, 2)"), true);
+
+        matchable::MatchableMaker loaded;
+        TEST_EQ(ok, loaded.load((dir / "C.h").string()), success);
+        TEST_EQ(ok, maker.diff(loaded).size(), (size_t) 0);
+
+        // a malformed row fails the import, leaving the records before it imported and the matchable
+        // modified, so that its header is saved again
+        TEST_EQ(ok, import(maker, "C", "name,n\na,3\nb,4,5\nd,6\n", csv), syntax_error);
+        TEST_EQ(ok, property(c, "a", "n"), std::string("3"));
+        TEST_EQ(ok, property(c, "b", "n"), std::string("2"));
+        TEST_EQ(ok, c->has_variant("d"), false);
+        TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+        TEST_EQ(ok, contains(read_file(dir / "C.h"), "MATCHABLE_VARIANT_PROPERTY_VALUE(C, a, n, 3)"), true);
+    }
+
+    // errors
+    {
+        matchable::MatchableMaker maker;
+        maker.grab("P")->add_property("int", "n");
+        TEST_EQ(ok, import(maker, "P", "name,m\na,1\n", csv), syntax_error);
+        TEST_EQ(ok, import(maker, "P", "name,n\n,1\n", csv), syntax_error);
+        TEST_EQ(ok, import(maker, "P", "name,n\na,\"1\n", csv), syntax_error);
+        std::string const unknown_in_second{"{\"name\": \"a\", \"n\": 1}\n{\"name\": \"b\", \"m\": 1}\n"};
+        TEST_EQ(ok, import(maker, "P", unknown_in_second, jsonl), syntax_error);
+        TEST_EQ(ok, maker.grab("P")->has_variant("a"), true);
+        TEST_EQ(ok, maker.grab("P")->has_variant("b"), false);
+        TEST_EQ(ok, import(maker, "P", "{\"name\": \"a\", \"n\": 1\n", jsonl), syntax_error);
+        TEST_EQ(ok, import(maker, "P", "[1]\n", jsonl), syntax_error);
+        TEST_EQ(
+            ok,
+            import(maker, "P", "", matchable::import__format::nil),
+            matchable::load__status::no_import_format::grab()
+        );
+        TEST_EQ(
+            ok,
+            maker.import_variants("P", (dir / "missing.csv").string(), csv),
+            matchable::load__status::io_error::grab()
+        );
+    }
+
+    std::filesystem::remove_all(dir);
+    return ok();
+}
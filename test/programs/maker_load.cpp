@@ -0,0 +1,110 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+static std::string read_file(std::filesystem::path const & filename)
+{
+    std::ifstream f{filename};
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+
+static void populate(matchable::MatchableMaker & maker)
+{
+    auto color = maker.grab("Color");
+    color->add_variant("Red");
+    color->add_variant("Yellow");
+
+    auto fruit = maker.grab("Fruit");
+    fruit->add_property("Color::Type", "color");
+    fruit->add_property("int", "seeds");
+    fruit->add_variant("apple");
+    fruit->add_variant("banana");
+    fruit->add_variant("kiwi_mns_fruit");
+    fruit->set_property("apple", "color", "Color::Red::grab()");
+    fruit->set_property("banana", "color", "Color::Yellow::grab()");
+    fruit->set_property("apple", "seeds", "5");
+    fruit->set_propertyvect("kiwi_mns_fruit", "color", {"Color::Red::grab()", "Color::Yellow::grab()"});
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    auto const dir = std::filesystem::temp_directory_path() / "matchable_test_maker_load";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    matchable::save__content::Flags content;
+    content.set(matchable::save__content::generated_matchable::grab());
+    content.set(matchable::save__content::matchables::grab());
+
+    // load -> save_as reproduces the saved header, generated_matchable included
+    for (auto mode : matchable::save__grow_mode::variants())
+    {
+        if (mode == matchable::save__grow_mode::table::grab())
+            continue;
+
+        matchable::MatchableMaker original;
+        populate(original);
+        auto const saved = dir / ("saved_" + mode.as_string() + ".h");
+        TEST_EQ(ok, original.save_as(saved.string(), content, mode), matchable::save__status::success::grab());
+
+        // growing leaves property declarations to the matchable's definition
+        matchable::MatchableMaker loaded;
+        if (mode == matchable::save__grow_mode::always::grab())
+        {
+            loaded.grab("Fruit")->add_property("Color::Type", "color");
+            loaded.grab("Fruit")->add_property("int", "seeds");
+        }
+        TEST_EQ(ok, loaded.load(saved.string()), matchable::load__status::success::grab());
+        TEST_EQ(ok, loaded.matchables.size(), (size_t) 2);
+        TEST_EQ(ok, loaded.matchables.count("generated_matchable"), (size_t) 0);
+        TEST_EQ(ok, original.diff(loaded).size(), (size_t) 0);
+
+        auto const resaved = dir / ("resaved_" + mode.as_string() + ".h");
+        TEST_EQ(ok, loaded.save_as(resaved.string(), content, mode), matchable::save__status::success::grab());
+        TEST_EQ(ok, read_file(resaved), read_file(saved));
+    }
+
+    // loaded values
+    {
+        matchable::MatchableMaker loaded;
+        TEST_EQ(ok, loaded.load((dir / "saved_wrap.h").string()), matchable::load__status::success::grab());
+        std::string value;
+        loaded.grab("Fruit")->get_property("apple", "seeds", value);
+        TEST_EQ(ok, value, std::string("5"));
+        std::vector<std::string> values;
+        loaded.grab("Fruit")->get_propertyvect("kiwi_mns_fruit", "color", values);
+        TEST_EQ(ok, values.size(), (size_t) 2);
+        TEST_EQ(ok, loaded.grab("Color")->has_variant("Yellow"), true);
+    }
+
+    // errors
+    {
+        matchable::MatchableMaker maker;
+        TEST_EQ(ok, maker.load((dir / "missing.h").string()), matchable::load__status::io_error::grab());
+
+        auto const bad = dir / "bad.h";
+        std::ofstream{bad} << "MATCHABLE(Color, Red)\nMATCHABLE_VARIANT_PROPERTY_VALUE(Fruit, apple)\n";
+        TEST_EQ(ok, maker.load(bad.string()), matchable::load__status::syntax_error::grab());
+
+        std::ofstream{bad} << "MATCHABLE(Color, Red, Green\n";
+        TEST_EQ(ok, maker.load(bad.string()), matchable::load__status::syntax_error::grab());
+    }
+
+    std::filesystem::remove_all(dir);
+    return ok();
+}
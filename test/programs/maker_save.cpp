@@ -0,0 +1,177 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+static std::string read_file(std::filesystem::path const & filename)
+{
+    std::ifstream f{filename};
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+
+static bool contains(std::string const & s, std::string const & part)
+{
+    return s.find(part) != std::string::npos;
+}
+
+
+static void populate(matchable::MatchableMaker & maker)
+{
+    auto color = maker.grab("Color");
+    color->add_variant("Red");
+    color->add_variant("Yellow");
+
+    auto fruit = maker.grab("Fruit");
+    fruit->add_property("Color::Type", "color");
+    fruit->add_property("int", "seeds");
+    fruit->add_variant("apple");
+    fruit->add_variant("banana");
+    fruit->set_property("apple", "color", "Color::Red::grab()");
+    fruit->set_property("banana", "seeds", "0");
+    fruit->set_propertyvect("banana", "color", {"Color::Yellow::grab()", "Color::Red::grab()"});
+
+    auto tool = maker.grab("Tool");
+    tool->add_property("int", "weight");
+    for (auto const & v : {"hammer", "saw", "drill", "chisel", "spade"})
+        tool->add_variant(v);
+    tool->set_property("saw", "weight", "2");
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    auto const dir = std::filesystem::temp_directory_path() / "matchable_test_maker_save";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    matchable::save__content::Flags content;
+    content.set(matchable::save__content::matchables::grab());
+
+    // sharded output
+    {
+        matchable::MatchableMaker maker;
+        populate(maker);
+        std::string const header = (dir / "sharded.h").string();
+        TEST_EQ(ok, maker.save_sharded(header, 2, content), matchable::save__status::success::grab());
+        TEST_EQ(ok, matchable::MatchableMaker::shard_filename(header, 1), (dir / "sharded_1.cpp").string());
+        TEST_EQ(ok, matchable::MatchableMaker::shard_filename("a.b/dict", 0), std::string("a.b/dict_0.cpp"));
+
+        // the header only declares, each shard grows and initializes whole dependency groups
+        std::string const h = read_file(header);
+        TEST_EQ(ok, contains(h, "PROPERTYx2_MATCHABLE(Color::Type, color, int, seeds, Fruit)"), true);
+        TEST_EQ(ok, contains(h, "apple"), false);
+        std::string const shard_0 = read_file(matchable::MatchableMaker::shard_filename(header, 0));
+        std::string const shard_1 = read_file(matchable::MatchableMaker::shard_filename(header, 1));
+        TEST_EQ(ok, contains(shard_0, "#include \"sharded.h\""), true);
+        TEST_EQ(ok, contains(shard_0, "GROW_MATCHABLE(Color"), contains(shard_0, "GROW_MATCHABLE(Fruit"));
+        TEST_EQ(ok, contains(shard_0, "GROW_MATCHABLE(Tool"), !contains(shard_0, "GROW_MATCHABLE(Fruit"));
+        TEST_EQ(ok, contains(shard_1, "GROW_MATCHABLE(Tool"), contains(shard_0, "GROW_MATCHABLE(Fruit"));
+
+        // loading the header and its shards gives back the same maker
+        matchable::MatchableMaker loaded;
+        TEST_EQ(ok, loaded.load(header), matchable::load__status::success::grab());
+        for (int i = 0; i < 2; ++i)
+            TEST_EQ(
+                ok,
+                loaded.load(matchable::MatchableMaker::shard_filename(header, i)),
+                matchable::load__status::success::grab()
+            );
+        TEST_EQ(ok, maker.diff(loaded).size(), (size_t) 0);
+
+        // more shards than dependency groups leaves some empty
+        TEST_EQ(ok, maker.save_sharded(header, 3, content), matchable::save__status::success::grab());
+        std::string const shard_2 = read_file(matchable::MatchableMaker::shard_filename(header, 2));
+        TEST_EQ(ok, contains(shard_2, "GROW_MATCHABLE"), false);
+    }
+
+    // table grow mode
+    {
+        matchable::MatchableMaker maker;
+        populate(maker);
+        auto const header = dir / "table.h";
+        TEST_EQ(
+            ok,
+            maker.save_as(header.string(), content, matchable::save__grow_mode::table::grab()),
+            matchable::save__status::success::grab()
+        );
+
+        // declarations in dependency order, each followed by its table
+        std::string const h = read_file(header);
+        TEST_EQ(ok, contains(h, "MATCHABLE(Color)\nnamespace Color\n"), true);
+        std::string const fruit_declaration{"PROPERTYx2_MATCHABLE(Color::Type, color, int, seeds, Fruit)\n"};
+        TEST_EQ(ok, contains(h, fruit_declaration + "namespace Fruit\n"), true);
+        TEST_EQ(ok, h.find("namespace Color") < h.find("PROPERTYx2_MATCHABLE"), true);
+        TEST_EQ(ok, contains(h, "        \"hammer\", \"saw\", \"drill\", \"chisel\", \"spade\",\n"), true);
+        TEST_EQ(ok, contains(h, "table_by_string_order[] = {\n        3, 2, 0, 1, 4,\n"), true);
+
+        // variants of table matchables have no class to grab(), so values refer to them by string
+        TEST_EQ(ok, contains(h, "Color::Red::grab()"), false);
+        TEST_EQ(ok, contains(h, "Color::from_string(\"Yellow\"), Color::from_string(\"Red\"),"), true);
+        TEST_EQ(ok, contains(h, "table_weight_positions[] = {\n        1,\n"), true);
+        TEST_EQ(ok, contains(h, "MATCHABLE_VARIANT_PROPERTY_VALUE"), false);
+    }
+
+    // cycles are reported by their edges, and whatever depends on them is left out as well
+    {
+        matchable::MatchableMaker maker;
+        maker.grab("A")->add_property("B::Type", "b");
+        maker.grab("B")->add_property("A::Type", "a");
+        maker.grab("C")->add_property("A::Type", "a");
+        maker.grab("D")->add_property("C::Type", "c");
+        maker.grab("E")->add_property("E::Type", "e");
+        auto const header = dir / "cyclic.h";
+
+        std::stringstream report;
+        auto const cout_buf = std::cout.rdbuf(report.rdbuf());
+        auto const status = maker.save_as(header.string(), content, matchable::save__grow_mode::wrap::grab());
+        std::cout.rdbuf(cout_buf);
+
+        TEST_EQ(ok, status, matchable::save__status::cyclic_dependencies::grab());
+        TEST_EQ(
+            ok,
+            report.str(),
+            std::string(
+                "WARNING! cyclic dependencies detected and omitted!\n"
+                "    A::b depends on B\n"
+                "    B::a depends on A\n"
+                "    C omitted as it depends on a cycle\n"
+                "    D omitted as it depends on a cycle\n"
+            )
+        );
+        std::string const h = read_file(header);
+        TEST_EQ(ok, contains(h, "PROPERTYx1_MATCHABLE(E::Type, e, E)"), true);
+        TEST_EQ(ok, contains(h, "_MATCHABLE(A::Type, a, C)"), false);
+    }
+
+    // errors
+    {
+        matchable::MatchableMaker maker;
+        populate(maker);
+        TEST_EQ(
+            ok,
+            maker.save_sharded((dir / "x.h").string(), 2, matchable::save__content::Flags{}),
+            matchable::save__status::no_content::grab()
+        );
+        TEST_EQ(
+            ok,
+            maker.save_sharded((dir / "missing" / "x.h").string(), 2, content),
+            matchable::save__status::io_error::grab()
+        );
+    }
+
+    std::filesystem::remove_all(dir);
+    return ok();
+}
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+static std::string read_file(std::filesystem::path const & filename)
+{
+    std::ifstream f{filename};
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+
+static bool contains(std::string const & s, std::string const & part)
+{
+    return s.find(part) != std::string::npos;
+}
+
+
+// mark filename as written long ago, so that rewriting it is noticed
+static void age(std::filesystem::path const & filename)
+{
+    std::filesystem::last_write_time(
+        filename,
+        std::filesystem::last_write_time(filename) - std::chrono::hours(24)
+    );
+}
+
+
+static bool rewritten(std::filesystem::path const & filename)
+{
+    return std::filesystem::last_write_time(filename) > std::filesystem::file_time_type::clock::now()
+                                                        - std::chrono::hours(1);
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    auto const dir = std::filesystem::temp_directory_path() / "matchable_test_maker_save_each";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    matchable::save__content::Flags content;
+    content.set(matchable::save__content::generated_matchable::grab());
+    content.set(matchable::save__content::matchables::grab());
+    auto const wrap = matchable::save__grow_mode::wrap::grab();
+
+    matchable::MatchableMaker maker;
+    auto a = maker.grab("A");
+    a->add_property("B::Type", "b");
+    a->add_variant("a0");
+    a->add_variant("a1");
+    a->set_property("a0", "b", "B::b0::grab()");
+    auto c = maker.grab("C");
+    c->add_variant("c0");
+
+    // B is not (yet) a matchable of the maker, so A does not include it
+    TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+    TEST_EQ(ok, contains(read_file(dir / "A.h"), "#include \"B.h\""), false);
+    TEST_EQ(ok, contains(read_file(dir / "generated_matchable.h"), "MATCHABLE(generated_matchable, A, C)"), true);
+
+    // saving again without changes rewrites nothing
+    for (auto const & name : {"A.h", "C.h", "generated_matchable.h"})
+        age(dir / name);
+    TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+    for (auto const & name : {"A.h", "C.h", "generated_matchable.h"})
+        TEST_EQ(ok, rewritten(dir / name), false);
+
+    // adding B rewrites A, which now depends on it
+    maker.grab("B")->add_variant("b0");
+    TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+    std::string const a_header = read_file(dir / "A.h");
+    TEST_EQ(ok, contains(a_header, "#include \"B.h\""), true);
+    TEST_EQ(ok, contains(a_header, "MATCHABLE_VARIANT_PROPERTY_VALUE(A, a0, b, B::b0::grab())"), true);
+    TEST_EQ(ok, contains(read_file(dir / "B.h"), "MATCHABLE(B, b0)"), true);
+    TEST_EQ(ok, rewritten(dir / "A.h"), true);
+    TEST_EQ(ok, rewritten(dir / "generated_matchable.h"), true);
+    TEST_EQ(ok, rewritten(dir / "C.h"), false);
+
+    // modifying one matchable rewrites only its header
+    for (auto const & name : {"A.h", "B.h", "C.h", "generated_matchable.h"})
+        age(dir / name);
+    c->add_variant("c1");
+    TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+    TEST_EQ(ok, rewritten(dir / "C.h"), true);
+    TEST_EQ(ok, rewritten(dir / "A.h"), false);
+    TEST_EQ(ok, rewritten(dir / "B.h"), false);
+    TEST_EQ(ok, rewritten(dir / "generated_matchable.h"), false);
+
+    // as does a modification leaving the printed header the same, which is not written again
+    age(dir / "C.h");
+    c->del_variant("c1");
+    c->add_variant("c1");
+    TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+    TEST_EQ(ok, rewritten(dir / "C.h"), false);
+
+    // headers removed behind the maker's back are written again
+    std::filesystem::remove(dir / "B.h");
+    TEST_EQ(ok, maker.save_each(dir.string(), content, wrap), matchable::save__status::success::grab());
+    TEST_EQ(ok, std::filesystem::exists(dir / "B.h"), true);
+
+    // the loaded headers give back the same maker
+    {
+        matchable::MatchableMaker loaded;
+        for (auto const & name : {"B.h", "C.h", "A.h"})
+            TEST_EQ(ok, loaded.load((dir / name).string()), matchable::load__status::success::grab());
+        TEST_EQ(ok, maker.diff(loaded).size(), (size_t) 0);
+    }
+
+    // another grow mode rewrites everything
+    TEST_EQ(
+        ok,
+        maker.save_each(dir.string(), content, matchable::save__grow_mode::always::grab()),
+        matchable::save__status::success::grab()
+    );
+    TEST_EQ(ok, contains(read_file(dir / "C.h"), "GROW_MATCHABLE(C, c0, c1)"), true);
+
+    // errors
+    TEST_EQ(
+        ok,
+        maker.save_each(dir.string(), matchable::save__content::Flags{}, wrap),
+        matchable::save__status::no_content::grab()
+    );
+    TEST_EQ(
+        ok,
+        maker.save_each((dir / "missing").string(), content, wrap),
+        matchable::save__status::io_error::grab()
+    );
+
+    // matchables depending on a cycle are left out, as save_as() leaves them out
+    {
+        auto const cyclic_dir = dir / "cyclic";
+        std::filesystem::create_directories(cyclic_dir);
+        matchable::MatchableMaker cyclic;
+        cyclic.grab("X")->add_property("Y::Type", "y");
+        cyclic.grab("Y")->add_property("X::Type", "x");
+        cyclic.grab("Z")->add_property("X::Type", "x");
+        cyclic.grab("W")->add_variant("w0");
+        auto const cyclic_dependencies = matchable::save__status::cyclic_dependencies::grab();
+        TEST_EQ(ok, cyclic.save_as((dir / "cyclic.h").string(), content, wrap), cyclic_dependencies);
+        TEST_EQ(ok, cyclic.save_each(cyclic_dir.string(), content, wrap), cyclic_dependencies);
+        TEST_EQ(ok, std::filesystem::exists(cyclic_dir / "W.h"), true);
+        for (auto const & name : {"X.h", "Y.h", "Z.h"})
+            TEST_EQ(ok, std::filesystem::exists(cyclic_dir / name), false);
+
+        // just growing needs no order
+        auto const always = matchable::save__grow_mode::always::grab();
+        TEST_EQ(ok, cyclic.save_each(cyclic_dir.string(), content, always), matchable::save__status::success::grab());
+        TEST_EQ(ok, std::filesystem::exists(cyclic_dir / "X.h"), true);
+    }
+
+    std::filesystem::remove_all(dir);
+    return ok();
+}
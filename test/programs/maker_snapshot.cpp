@@ -0,0 +1,134 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+static std::string read_file(std::filesystem::path const & filename)
+{
+    std::ifstream f{filename, std::ios::binary};
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+
+static void write_file(std::filesystem::path const & filename, std::string const & contents)
+{
+    std::ofstream{filename, std::ios::binary} << contents;
+}
+
+
+static void populate(matchable::MatchableMaker & maker)
+{
+    auto color = maker.grab("Color");
+    color->add_variant("Red");
+    color->add_variant("Yellow");
+
+    auto fruit = maker.grab("Fruit");
+    fruit->add_property("Color::Type", "color");
+    fruit->add_property("int", "seeds");
+    fruit->add_variant("apple");
+    fruit->add_variant("banana");
+    fruit->add_variant("cherry");
+    fruit->set_property("apple", "color", "Color::Red::grab()");
+    fruit->set_property("cherry", "seeds", "1");
+    fruit->set_propertyvect("banana", "color", {"Color::Yellow::grab()", "Color::Red::grab()"});
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    auto const dir = std::filesystem::temp_directory_path() / "matchable_test_maker_snapshot";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto const snapshot = dir / "maker.snapshot";
+
+    // save -> load round trip
+    {
+        matchable::MatchableMaker original;
+        populate(original);
+        TEST_EQ(ok, original.save_snapshot(snapshot.string()), matchable::save__status::success::grab());
+
+        matchable::MatchableMaker loaded;
+        TEST_EQ(ok, loaded.load_snapshot(snapshot.string()), matchable::load__status::success::grab());
+        TEST_EQ(ok, loaded.matchables.size(), (size_t) 2);
+        TEST_EQ(ok, original.diff(loaded).size(), (size_t) 0);
+        std::vector<std::string> values;
+        loaded.grab("Fruit")->get_propertyvect("banana", "color", values);
+        TEST_EQ(ok, values.size(), (size_t) 2);
+        TEST_EQ(ok, loaded.grab("Fruit")->has_variant("cherry"), true);
+
+        // saving the loaded maker gives the same snapshot
+        auto const resaved = dir / "resaved.snapshot";
+        TEST_EQ(ok, loaded.save_snapshot(resaved.string()), matchable::save__status::success::grab());
+        TEST_EQ(ok, read_file(resaved), read_file(snapshot));
+
+        // loaded into the pool of the maker
+        std::pmr::memory_resource * const resource = loaded.grab("Other")->variants.get_allocator().resource();
+        TEST_EQ(ok, loaded.grab("Fruit")->variants.get_allocator().resource(), resource);
+        TEST_EQ(ok, loaded.grab("Fruit")->variants.front().variant_name.get_allocator().resource(), resource);
+    }
+
+    // loading replaces matchables of the same name in place and keeps the others
+    {
+        matchable::MatchableMaker maker;
+        auto fruit = maker.grab("Fruit");
+        fruit->add_variant("durian");
+        maker.grab("Z")->add_variant("z");
+        TEST_EQ(ok, maker.load_snapshot(snapshot.string()), matchable::load__status::success::grab());
+        TEST_EQ(ok, maker.grab("Fruit"), fruit);
+        TEST_EQ(ok, fruit->has_variant("durian"), false);
+        TEST_EQ(ok, fruit->has_variant("apple"), true);
+        TEST_EQ(ok, fruit->variants.size(), (size_t) 3);
+        TEST_EQ(ok, maker.grab("Z")->has_variant("z"), true);
+    }
+
+    // a snapshot failing to load leaves the maker unchanged
+    {
+        std::string const contents = read_file(snapshot);
+        auto const truncated = dir / "truncated.snapshot";
+        for (size_t size = 0; size < contents.size(); ++size)
+        {
+            matchable::MatchableMaker maker;
+            maker.grab("Fruit")->add_variant("durian");
+            maker.grab("Z")->add_variant("z");
+            write_file(truncated, contents.substr(0, size));
+            if (maker.load_snapshot(truncated.string()) != matchable::load__status::bad_snapshot::grab())
+                TEST_FAIL(ok);
+            TEST_EQ(ok, maker.matchables.size(), (size_t) 2);
+            TEST_EQ(ok, maker.grab("Fruit")->variants.size(), (size_t) 1);
+            TEST_EQ(ok, maker.grab("Z")->has_variant("z"), true);
+        }
+
+        // trailing bytes
+        write_file(truncated, contents + std::string(4, '\0'));
+        matchable::MatchableMaker maker;
+        TEST_EQ(ok, maker.load_snapshot(truncated.string()), matchable::load__status::bad_snapshot::grab());
+        TEST_EQ(ok, maker.matchables.size(), (size_t) 0);
+
+        // another version
+        std::string other_version{contents};
+        other_version[8] = 99;
+        write_file(truncated, other_version);
+        TEST_EQ(
+            ok,
+            maker.load_snapshot(truncated.string()),
+            matchable::load__status::unsupported_version::grab()
+        );
+
+        TEST_EQ(ok, maker.load_snapshot((dir / "missing").string()), matchable::load__status::io_error::grab());
+    }
+
+    std::filesystem::remove_all(dir);
+    return ok();
+}
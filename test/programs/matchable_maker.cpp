@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matchable/MatchableMaker.h"
+#include "test_ok.h"
+
+
+
+static std::string joined(std::vector<std::string> const & strings)
+{
+    std::string ret;
+    for (auto const & s : strings)
+        ret += (ret.empty() ? "" : " ") + s;
+    return ret;
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    // variant name indexes
+    {
+        matchable::MatchableMaker maker;
+        auto m = maker.grab("Word");
+        for (auto const & v : {"abd", "x", "abc", "ab"})
+            m->add_variant(v);
+        std::vector<std::string> result;
+        m->variants_starting_with("ab", result);
+        TEST_EQ(ok, joined(result), std::string("abd abc ab"));
+        TEST_EQ(ok, m->has_variant("abc"), true);
+
+        m->del_variant("abc");
+        m->variants_starting_with("ab", result);
+        TEST_EQ(ok, joined(result), std::string("abd ab"));
+        TEST_EQ(ok, m->has_variant("abc"), false);
+        m->variants_starting_with("y", result);
+        TEST_EQ(ok, result.size(), (size_t) 0);
+    }
+
+    // direct modification of variants keeping their number, noticed by prefix queries
+    {
+        matchable::MatchableMaker maker;
+        auto m = maker.grab("Word");
+        for (auto const & v : {"abc", "abd", "x"})
+            m->add_variant(v);
+        m->variants.erase(m->variants.begin());
+        m->variants.push_back(matchable::MatchableVariant{"abq", {}});
+        std::vector<std::string> result;
+        m->variants_starting_with("ab", result);
+        TEST_EQ(ok, joined(result), std::string("abd abq"));
+        TEST_EQ(ok, m->has_variant("abc"), false);
+        TEST_EQ(ok, m->has_variant("abq"), true);
+    }
+
+    // and by has_variant()
+    {
+        matchable::MatchableMaker maker;
+        auto m = maker.grab("Word");
+        for (auto const & v : {"abc", "abd", "x"})
+            m->add_variant(v);
+        m->variants.erase(m->variants.begin());
+        m->variants.push_back(matchable::MatchableVariant{"abq", {}});
+        TEST_EQ(ok, m->has_variant("abc"), false);
+        std::vector<std::string> result;
+        m->variants_starting_with("ab", result);
+        TEST_EQ(ok, joined(result), std::string("abd abq"));
+    }
+
+    // rebuilding the indexes reuses the names already indexed
+    {
+        matchable::MatchableMaker maker;
+        auto m = maker.grab("Word");
+        for (int i = 0; i < 100; ++i)
+            m->add_variant("w" + std::to_string(i));
+        for (int i = 0; i < 300; ++i)
+        {
+            std::rotate(m->variants.begin(), m->variants.begin() + 1, m->variants.end());
+            if (m->has_variant("w" + std::to_string(i % 100)) != true)
+                TEST_FAIL(ok);
+        }
+        TEST_EQ(ok, std::string(m->variants.front().variant_name), std::string("w0"));
+        std::vector<std::string> result;
+        m->variants_starting_with("w9", result);
+        TEST_EQ(ok, joined(result), std::string("w9 w90 w91 w92 w93 w94 w95 w96 w97 w98 w99"));
+    }
+
+    // variants and property values allocate from the pool the maker's matchables share
+    {
+        matchable::MatchableMaker maker;
+        auto m = maker.grab("Word");
+        m->add_property("std::string", "spelling");
+        m->add_variant("w");
+        m->set_property("w", "spelling", "a longer spelling than fits in place");
+        m->set_propertyvect("w", "spelling", {"a longer spelling than fits in place"});
+        std::pmr::memory_resource * const resource = maker.grab("Other")->variants.get_allocator().resource();
+        TEST_NE(ok, resource, std::pmr::get_default_resource());
+        TEST_EQ(ok, m->variants.get_allocator().resource(), resource);
+        auto const & property = m->variants.front().properties.front();
+        TEST_EQ(ok, m->variants.front().variant_name.get_allocator().resource(), resource);
+        TEST_EQ(ok, property.value.get_allocator().resource(), resource);
+        TEST_EQ(ok, property.values.front().get_allocator().resource(), resource);
+    }
+
+    return ok();
+}
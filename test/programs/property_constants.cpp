@@ -0,0 +1,64 @@
+#include <iostream>
+
+#include "matchable/matchable.h"
+#include "test_ok.h"
+
+
+
+PROPERTYx2_MATCHABLE(
+    double, mass,
+    int, moons,
+    Planet,
+    Mercury,
+    Venus,
+    Earth,
+    Mars
+)
+MATCHABLE_PROPERTY_CONSTANTS(Planet, mass, 0.330, 4.87, 5.97, 0.642)
+MATCHABLE_PROPERTY_CONSTANTS(Planet, moons, 0, 0, 1)
+#ifndef MATCHABLE_OMIT_BY_INDEX
+MATCHABLE_VARIANT_PROPERTY_VALUE(Planet, Mars, moons, 2)
+GROW_MATCHABLE(Planet, Jupiter)
+MATCHABLE_VARIANT_PROPERTY_VALUE(Planet, Jupiter, mass, 1898.0)
+#endif
+
+
+static_assert(Planet::IPlanet::mass_constants<>::size == 4);
+static_assert(Planet::IPlanet::moons_constants<>::values[2] == 1);
+
+
+
+int main()
+{
+    test_ok ok;
+
+    for (auto p : Planet::variants())
+        std::cout << p << " has mass " << p.as_mass() << " and " << p.as_moons() << " moon(s)" << std::endl;
+
+#ifdef MATCHABLE_OMIT_BY_INDEX
+    // tables are in by string order: Earth, Mars, Mercury, Venus
+    TEST_EQ(ok, Planet::Earth::grab().as_mass(), 0.330);
+    TEST_EQ(ok, Planet::Venus::grab().as_mass(), 0.642);
+    TEST_EQ(ok, Planet::Venus::grab().is_moons_constant(), false);
+#else
+    TEST_EQ(ok, Planet::Mercury::grab().as_mass(), 0.330);
+    TEST_EQ(ok, Planet::Earth::grab().as_mass(), 5.97);
+    TEST_EQ(ok, Planet::Mars::grab().as_mass(), 0.642);
+    TEST_EQ(ok, Planet::Earth::grab().as_moons(), 1);
+    TEST_EQ(ok, &Planet::Venus::grab().as_mass(), &Planet::IPlanet::mass_constants<>::values[1]);
+
+    // variants beyond the end of a table are ordinary properties
+    TEST_EQ(ok, Planet::Mars::grab().is_moons_constant(), false);
+    TEST_EQ(ok, Planet::Mars::grab().as_moons(), 2);
+    TEST_EQ(ok, Planet::Jupiter::grab().is_mass_constant(), false);
+    TEST_EQ(ok, Planet::Jupiter::grab().as_mass(), 1898.0);
+#endif
+    TEST_EQ(ok, Planet::Venus::grab().is_mass_constant(), true);
+
+    // nil is never constant
+    TEST_EQ(ok, Planet::nil.is_mass_constant(), false);
+    Planet::nil.set_mass(-1.0);
+    TEST_EQ(ok, Planet::nil.as_mass(), -1.0);
+
+    return ok();
+}
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #include "matchable/matchable.h"
@@ -105,5 +106,59 @@ int main()
     if (stable_algorithms_by_space_complexity != truth)
         TEST_FAIL(ok);
 
+    // the same result from a query
+    matchable::Query<SortingAlgorithm::Type> stable_query;
+    stable_query
+        .where([](auto const & sa) { return sa.as_stability() == Stability::Stable::grab(); })
+        .order_by([](auto const & sa) { return sa.as_space_complexity(); });
+    if (stable_query.results() != truth)
+        TEST_FAIL(ok);
+
+    // cached results are returned until a property changes
+    auto const * cached = &stable_query.results();
+    TEST_EQ(ok, &stable_query.results(), cached);
+    TEST_EQ(ok, stable_query.results().size(), (size_t) 8);
+    SortingAlgorithm::HeapSort::grab().set_stability(Stability::Stable::grab());
+    TEST_EQ(ok, stable_query.results().size(), (size_t) 9);
+    TEST_EQ(ok, stable_query.results()[1], SortingAlgorithm::HeapSort::grab());
+    SortingAlgorithm::HeapSort::grab().set_stability(Stability::Unstable::grab());
+    if (stable_query.results() != truth)
+        TEST_FAIL(ok);
+
+    // multiple predicates and keys, later keys break ties of earlier ones
+    matchable::Query<SortingAlgorithm::Type> in_place_query;
+    in_place_query
+        .where(
+            [](auto const & sa) { return sa.as_space_complexity() == SpaceComplexity::O_parl_1_parr_::grab(); }
+        )
+        .where([](auto const & sa) { return sa != SortingAlgorithm::BubbleSort::grab(); })
+        .order_by([](auto const & sa) { return sa.as_stability(); })
+        .order_by([](auto const & sa) { return sa.as_string(); });
+    std::vector<SortingAlgorithm::Type> in_place_truth{
+        SortingAlgorithm::InsertionSort::grab(),
+        SortingAlgorithm::HeapSort::grab(),
+        SortingAlgorithm::SelectionSort::grab(),
+        SortingAlgorithm::ShellSort::grab()
+    };
+    if (in_place_query.results() != in_place_truth)
+        TEST_FAIL(ok);
+
+    // variants hidden by Unmatchable are excluded while hidden
+    {
+        matchable::Unmatchable<SortingAlgorithm::Type> um{SortingAlgorithm::ShellSort::grab()};
+        TEST_EQ(ok, in_place_query.results().size(), (size_t) 3);
+    }
+    TEST_EQ(ok, in_place_query.results().size(), (size_t) 4);
+
+    // results cached under one thread's scope are not returned to a thread that hides nothing
+    {
+        matchable::Unmatchable<SortingAlgorithm::Type> um{SortingAlgorithm::ShellSort::grab()};
+        TEST_EQ(ok, in_place_query.results().size(), (size_t) 3);
+        size_t other_thread_size{0};
+        std::thread([&]() { other_thread_size = in_place_query.results().size(); }).join();
+        TEST_EQ(ok, other_thread_size, (size_t) 4);
+        TEST_EQ(ok, in_place_query.results().size(), (size_t) 3);
+    }
+
     return ok();
 }
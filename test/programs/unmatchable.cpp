@@ -1,4 +1,5 @@
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #include "matchable/matchable_fwd.h"
@@ -477,6 +478,43 @@ int main()
         TEST_EQ(ok, Digit::from_index(8), Digit::nil);
     }
 
+    // hiding a variant that an enclosing scope already hides leaves it hidden until that scope exits
+    {
+        UNMATCHABLE(Digit, Four);
+        {
+            matchable::Unmatchable<Digit::Type> unmatchable{{Digit::Four::grab(), Digit::Five::grab()}};
+            TEST_EQ(ok, Digit::variants().size(), (size_t) 8);
+        }
+        TEST_EQ(ok, Digit::variants().size(), (size_t) 9);
+        TEST_EQ(ok, Digit::from_string("Four"), Digit::nil);
+        TEST_EQ(ok, Digit::from_string("Five"), Digit::Five::grab());
+
+        // MatchBoxes created while variants are hidden still have room for every variant
+        matchable::MatchBox<Digit::Type, int> mb;
+        mb.set(Digit::Nine::grab(), 9);
+        TEST_EQ(ok, mb.at(Digit::Nine::grab()), 9);
+    }
+    TEST_EQ(ok, Digit::variants().size(), (size_t) 10);
+
+    // scopes only hide variants from the thread that entered them
+    {
+        UNMATCHABLE(Digit, Zero);
+        size_t other_thread_size{0};
+        Digit::Type other_thread_zero;
+        std::thread other{
+            [&]()
+            {
+                other_thread_size = Digit::variants().size();
+                other_thread_zero = Digit::from_string("Zero");
+            }
+        };
+        other.join();
+        TEST_EQ(ok, other_thread_size, (size_t) 10);
+        TEST_EQ(ok, other_thread_zero, Digit::Zero::grab());
+        TEST_EQ(ok, Digit::variants().size(), (size_t) 9);
+        TEST_EQ(ok, Digit::from_string("Zero"), Digit::nil);
+    }
+
     TEST_EQ(ok, Digit::from_string("Seven"), Digit::Seven::grab());
     TEST_EQ(ok, Digit::from_string("Eight"), Digit::Eight::grab());
     TEST_EQ(ok, Digit::from_index(7), Digit::Seven::grab());
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matchable/matchable.h"
+#include "test_ok.h"
+
+
+
+MATCHABLE(Color, Red, Green)
+PROPERTYx2_MATCHABLE(int, legs, Color::Type, color, Animal, Zebra)
+MATCHABLE_VARIANT_PROPERTY_VALUE(Animal, Zebra, legs, 4)
+
+// as emitted by MatchableMaker with save__grow_mode::table
+namespace Animal
+{
+    inline char const * const table_identifiers[] = {
+        "cat", "ant", "Bee", "spider_mns_monkey", "eel"
+    };
+    inline constexpr int table_by_string_order[] = {2, 1, 0, 4, 3};
+    inline std::vector<Type> const table_variants =
+            ::matchable::register_variant_table<Type>(table_identifiers, table_by_string_order);
+    inline constexpr int table_legs_positions[] = {0, 1, 2, 3};
+    inline constexpr int table_legs_value_indexes[] = {0, 1, 1, 0};
+    inline int const table_legs_values[] = {4, 6};
+    inline bool const table_legs_set = ::matchable::set_property_column(
+        table_variants,
+        table_legs_positions,
+        table_legs_value_indexes,
+        table_legs_values,
+        [](Type v, auto const & value) { v.set_legs(value); }
+    );
+    inline constexpr int table_color_vect_positions[] = {2, 4};
+    inline constexpr int table_color_vect_offsets[] = {0, 2, 3};
+    inline constexpr int table_color_vect_value_indexes[] = {0, 1, 1};
+    inline Color::Type const table_color_vect_values[] = {Color::Red::grab(), Color::Green::grab()};
+    inline bool const table_color_vect_set = ::matchable::set_property_vect_column(
+        table_variants,
+        table_color_vect_positions,
+        table_color_vect_offsets,
+        table_color_vect_value_indexes,
+        table_color_vect_values,
+        [](Type v, auto const & values) { v.set_color_vect(values); }
+    );
+}
+
+
+
+static std::string joined(std::vector<Animal::Type> const & variants)
+{
+    std::string ret;
+    for (auto const & v : variants)
+        ret += (ret.empty() ? "" : " ") + v.as_string();
+    return ret;
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    TEST_EQ(ok, Animal::variants().size(), (size_t) 6);
+    TEST_EQ(ok, joined(Animal::variants_by_string()), std::string("Bee Zebra ant cat eel spider-monkey"));
+#ifndef MATCHABLE_OMIT_BY_INDEX
+    TEST_EQ(ok, joined(Animal::variants()), std::string("Zebra cat ant Bee spider-monkey eel"));
+    TEST_EQ(ok, Animal::from_string("ant").as_index(), 2);
+    TEST_EQ(ok, Animal::from_index(4).as_string(), std::string("spider-monkey"));
+#endif
+
+    // table variants behave like any other variant
+    Animal::Type spider_monkey = Animal::from_string("spider-monkey");
+    TEST_EQ(ok, spider_monkey.is_nil(), false);
+    TEST_EQ(ok, spider_monkey.as_identifier_string(), std::string("spider_mns_monkey"));
+    TEST_EQ(ok, spider_monkey, Animal::table_variants[3]);
+    TEST_EQ(ok, spider_monkey.as_legs(), 4);
+    TEST_EQ(ok, Animal::from_string("ant").as_legs(), 6);
+    TEST_EQ(ok, Animal::from_string("eel").as_legs(), 0);
+#ifndef MATCHABLE_OMIT_BY_INDEX
+    // properties are stored by string index when omitting by index, so values set before variants are
+    // added do not follow their variants
+    TEST_EQ(ok, Animal::Zebra::grab().as_legs(), 4);
+#endif
+    TEST_EQ(ok, Animal::from_string("Bee").as_color_vect().size(), (size_t) 2);
+    TEST_EQ(ok, Animal::from_string("eel").as_color_vect()[0], Color::Green::grab());
+    TEST_EQ(ok, Animal::from_string("Zebra").as_by_string_index(), 1);
+
+    Animal::Type copy = spider_monkey;
+    copy.set_legs(2);
+    TEST_EQ(ok, Animal::from_string("spider-monkey").as_legs(), 2);
+
+    bool matched{false};
+    Animal::from_string("cat").match({{Animal::table_variants[0], [&](){ matched = true; }}});
+    TEST_EQ(ok, matched, true);
+
+    // registering at runtime, the given order is verified and replaced if wrong
+    std::vector<std::string_view> const identifiers{"yak", "fox", "wolf"};
+    std::vector<int> const wrong_order{0, 1, 2};
+    auto added = matchable::register_variant_table<Animal::Type>(identifiers, wrong_order);
+    TEST_EQ(ok, added.size(), (size_t) 3);
+    TEST_EQ(ok, Animal::from_string("fox"), added[1]);
+    TEST_EQ(
+        ok,
+        joined(Animal::variants_by_string()),
+        std::string("Bee Zebra ant cat eel fox spider-monkey wolf yak")
+    );
+#ifndef MATCHABLE_OMIT_BY_INDEX
+    TEST_EQ(ok, Animal::from_string("spider-monkey").as_legs(), 2);
+    TEST_EQ(ok, Animal::from_string("Bee").as_color_vect()[1], Color::Green::grab());
+#endif
+
+    return ok();
+}
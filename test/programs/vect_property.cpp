@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matchable/matchable.h"
+#include "test_ok.h"
+
+
+
+PROPERTYx1_MATCHABLE(int, prime, Range, Small, Medium, Large, Empty)
+MATCHABLE_VARIANT_PROPERTY_VALUES(Range, Small, prime, 2, 3, 5, 7)
+MATCHABLE_VARIANT_PROPERTY_VALUES(Range, Medium, prime, 11, 13)
+MATCHABLE_NIL_PROPERTY_VALUES(Range, prime, -1)
+
+
+
+template<typename S>
+std::string joined(S s)
+{
+    std::string ret;
+    for (auto i : s)
+        ret += std::to_string(i) + " ";
+    return ret;
+}
+
+
+
+int main()
+{
+    test_ok ok;
+
+    auto small = Range::Small::grab();
+    auto medium = Range::Medium::grab();
+    auto large = Range::Large::grab();
+
+    TEST_EQ(ok, joined(small.as_prime_vect()), std::string("2 3 5 7 "));
+    TEST_EQ(ok, joined(medium.as_prime_vect()), std::string("11 13 "));
+    TEST_EQ(ok, large.as_prime_vect().empty(), true);
+    TEST_EQ(ok, Range::Empty::grab().as_prime_vect().size(), (size_t) 0);
+    TEST_EQ(ok, joined(Range::nil.as_prime_vect()), std::string("-1 "));
+
+    // shrinking and regrowing within the original slice
+    small.set_prime_vect({17});
+    TEST_EQ(ok, joined(small.as_prime_vect()), std::string("17 "));
+    small.set_prime_vect({17, 19, 23});
+    TEST_EQ(ok, joined(small.as_prime_vect()), std::string("17 19 23 "));
+    TEST_EQ(ok, joined(medium.as_prime_vect()), std::string("11 13 "));
+
+    // growing past the slice (repeatedly, forcing compaction) keeps the other variants intact
+    for (int i = 0; i < 50; ++i)
+    {
+        std::vector<int> v(i + 5, i);
+        large.set_prime_vect(v);
+        TEST_EQ(ok, joined(large.as_prime_vect()), joined(v));
+    }
+    TEST_EQ(ok, joined(small.as_prime_vect()), std::string("17 19 23 "));
+    TEST_EQ(ok, joined(medium.as_prime_vect()), std::string("11 13 "));
+
+    // setting from a span of another variant's values
+    auto m = medium.as_prime_vect();
+    small.set_prime_vect(std::vector<int>(m.begin(), m.end()));
+    TEST_EQ(ok, joined(small.as_prime_vect()), std::string("11 13 "));
+
+    // mutable access writes through to storage
+    for (auto & p : medium.as_mutable_prime_vect())
+        p *= 10;
+    TEST_EQ(ok, joined(medium.as_prime_vect()), std::string("110 130 "));
+
+    return ok();
+}